@@ -10,7 +10,15 @@
 #include "Stack.hpp"
 #include "Queue.hpp"
 #include "BinarySearch.hpp"
+#include "BPlusTree.hpp"
+#include "AVLTree.hpp"
+#include "KeyDistribution.hpp"
+#include "FastRandom.hpp"
+#include "OpTrace.hpp"
 #include "LinkedList.hpp"
+#include "LockFreeStack.hpp"
+#include "LockFreeQueue.hpp"
+#include "LatencyHistogram.hpp"
 // #include "numatype.hpp"
 #include <random>
 #include <iostream>
@@ -24,6 +32,10 @@
 #include <pthread.h>
 #include <map>
 #include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstring>
 #include "umf_numa_allocator.hpp"
 
 #define MEGABYTE 1048576
@@ -32,10 +44,14 @@
 using namespace std::chrono;
 std::vector<Stack*> Stacks0;
 std::vector<Stack*> Stacks1;
+std::vector<numa_ref<Stack,0>> numaStacks0;
+std::vector<numa_ref<Stack,1>> numaStacks1;
 // int64_t ops0=0;
 // int64_t ops1=0;
 int64_t ops0=0;
 int64_t ops1=0;
+// [thread node][memory node] ops of the last run, set by stop_reporter()
+int64_t pairOps[2][2];
 
 int sharedCounter = 0;
 char* Arrays0;
@@ -54,21 +70,72 @@ std::mutex* globalLK;
 std::vector<int64_t> globalOps0;
 std::vector<int64_t> globalOps1;
 
+/*
+ * One counter per worker (indexed by tid), each on its own cache line.
+ * Only the owning thread writes it, with a plain relaxed store, so the
+ * hot loop never takes a lock or an atomic RMW. The reporter thread reads
+ * all of them every interval to fill globalOps0/1, and stop_reporter()
+ * folds them into ops0/ops1 once the workers are done.
+ */
+struct alignas(64) thread_counter{
+	std::atomic<int64_t> ops{0};
+	std::atomic<int64_t> remote{0};          // ops that went to the other node's half
+	std::atomic<int> node{0};
+#ifdef LATENCY_HIST
+	// [0] push/add/append/lookup, [1] pop/del/removeHead/transaction
+	alignas(64) LatencyHistogram latency[2];
+#endif
+};
+thread_counter* threadOps;
+int num_counters = 0;
+
+std::thread* reporter;
+std::mutex reporter_lk;
+std::condition_variable reporter_cv;
+bool reporter_stop = false;
+
 std::vector<Queue*> Queues0;
 std::vector<Queue*> Queues1;
+std::vector<numa_ref<Queue,0>> numaQueues0;
+std::vector<numa_ref<Queue,1>> numaQueues1;
 std::vector<mutex*> Queue_lk0;
 std::vector<mutex*> Queue_lk1;
 
+// lfstack/lfqueue: no per-structure locks
+std::vector<LockFreeStack*> LFStacks0;
+std::vector<LockFreeStack*> LFStacks1;
+std::vector<numa_ref<LockFreeStack,0>> numaLFStacks0;
+std::vector<numa_ref<LockFreeStack,1>> numaLFStacks1;
+
+std::vector<LockFreeQueue*> LFQueues0;
+std::vector<LockFreeQueue*> LFQueues1;
+std::vector<numa_ref<LockFreeQueue,0>> numaLFQueues0;
+std::vector<numa_ref<LockFreeQueue,1>> numaLFQueues1;
+
 
 std::vector<BinarySearchTree*> BSTs0;
 std::vector<BinarySearchTree*> BSTs1;
+std::vector<numa_ref<BinarySearchTree,0>> numaBSTs0;
+std::vector<numa_ref<BinarySearchTree,1>> numaBSTs1;
 std::vector<mutex*> BST_lk0;
 std::vector<mutex*> BST_lk1;
-std::vector<mutex*> BST_reader_lk0;
-std::vector<mutex*> BST_reader_lk1;
+
+// --DS_name=btree: same init and test loop as bst, sharing BST_lk0/1
+std::vector<BPlusTree*> BTrees0;
+std::vector<BPlusTree*> BTrees1;
+std::vector<numa_ref<BPlusTree,0>> numaBTrees0;
+std::vector<numa_ref<BPlusTree,1>> numaBTrees1;
+
+// --DS_name=avl: same init and test loop as bst, sharing BST_lk0/1
+std::vector<AVLTree*> AVLs0;
+std::vector<AVLTree*> AVLs1;
+std::vector<numa_ref<AVLTree,0>> numaAVLs0;
+std::vector<numa_ref<AVLTree,1>> numaAVLs1;
 
 std::vector<LinkedList*> LLs0;
 std::vector<LinkedList*> LLs1;
+std::vector<numa_ref<LinkedList,0>> numaLLs0;
+std::vector<numa_ref<LinkedList,1>> numaLLs1;
 std::vector<mutex*> LL_lk0;
 std::vector<mutex*> LL_lk1;
 
@@ -82,6 +149,109 @@ struct prefill_percentage{
 	float update;
 };
 
+extern std::string DS_config;
+extern std::string DS_name;
+extern std::string bst_reads;
+extern std::string key_dist;
+extern std::string ds_dist;
+extern std::string rng_name;
+extern int64_t rng_stream;
+extern op_trace_file* op_trace;
+extern std::vector<int> locality_matrix;
+extern int batch_size;
+
+/*
+ * Every pool exists twice: plain T* for DS_config=regular and numa_ref<T,N>
+ * for DS_config=numa. The init and test bodies are templates over the pool
+ * type (their parameters keep the names of the pools they replace) and the
+ * exported functions pick the instantiation once, so the hot loops call the
+ * numa<T,N> members directly instead of through a reinterpret_cast'ed T*.
+ */
+template<typename T>
+static void make_ds(T*& slot){
+	slot = new T();
+}
+
+template<typename T, int NodeID>
+static void make_ds(numa_ref<T,NodeID>& slot){
+	slot = numa_ref<T,NodeID>::make();
+}
+
+/*
+ * The test loops are also templates over their generator (--rng). with_rng
+ * picks it once per thread and hands run() a tag carrying the type; with
+ * --rng_stream=N the generator is wrapped in replay<>, which draws N values
+ * up front, before the loop's barrier, on the thread that consumes them.
+ * The inits keep std::mt19937: they are not timed per op.
+ */
+template<typename T>
+struct rng_tag{
+	typedef T type;
+};
+
+template<typename Rng>
+static Rng make_rng(uint64_t seed){
+	if constexpr (is_replay<Rng>::value){
+		return Rng(seed, rng_stream);
+	}
+	else{
+		return Rng(seed);
+	}
+}
+
+template<typename G, typename F>
+static void with_rng_stream(F&& run){
+	if(rng_stream > 0){
+		run(rng_tag<replay<G>>());
+	}
+	else{
+		run(rng_tag<G>());
+	}
+}
+
+template<typename F>
+static void with_rng(F&& run){
+	if(rng_name == "xoshiro"){
+		with_rng_stream<xoshiro256pp>(run);
+	}
+	else if(rng_name == "wyrand"){
+		with_rng_stream<wyrand>(run);
+	}
+	else{
+		with_rng_stream<std::mt19937>(run);
+	}
+}
+
+extern numa_thread_pool* workers;
+
+/*
+ * One structure to prefill: slot ds of a pool half gets count elements.
+ */
+struct prefill_pick{
+	int ds;
+	int count;
+};
+
+/*
+ * Prefill both pool halves on the harness's worker pool. fill(k, pick) runs
+ * for every pick of half k on a worker of node index k, so each element is
+ * first touched by a thread on the node its structure lives on, and each
+ * node's workers split that half between them. A slot always goes to the
+ * same worker (ds % workers_on(k)), so repeated picks of one slot are
+ * filled one after another and the fills need no locks.
+ */
+static void prefill_on_nodes(const std::vector<prefill_pick> (&picks)[2], const std::function<void(int, const prefill_pick&)>& fill)
+{
+	workers->run([&](int node, int index, int tid){
+		int stride = workers->workers_on(node);
+		for(const prefill_pick& pick : picks[node]){
+			if(pick.ds % stride == index){
+				fill(node, pick);
+			}
+		}
+	});
+}
+
 // chrono::high_resolution_clock::time_point startTimer;
 // chrono::high_resolution_clock::time_point endTimer;
 
@@ -103,8 +273,10 @@ int checkNUMANode(void* ptr) {
 void global_init(int num_threads, int duration, int interval){
 	pthread_barrier_init(&bar, NULL, num_threads);
 	pthread_barrier_init(&init_bar, NULL, 2);
-	globalOps0.resize(duration/interval);
-	globalOps1.resize(duration/interval);
+	globalOps0.clear();
+	globalOps1.clear();
+	num_counters = num_threads;
+	threadOps = new thread_counter[num_counters];
 	ops0 = 0;
 	ops1 = 0;
 	printLK = new std::mutex();
@@ -113,20 +285,147 @@ void global_init(int num_threads, int duration, int interval){
 	Array_Lk1 = new mutex();
 }
 
+static thread_counter& claim_counter(int tid, int node){
+	thread_counter& c = threadOps[tid];
+	c.node.store(node, std::memory_order_relaxed);
+	return c;
+}
+
+static inline void count_op(thread_counter& c){
+	c.ops.store(c.ops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+static inline void count_op(thread_counter& c, bool remote, int64_t n = 1){
+	c.ops.store(c.ops.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	if(remote){
+		c.remote.store(c.remote.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+}
+
+/*
+ * The crossover threshold a worker on node index node uses. The pool loops
+ * send an op to the other half when x < crossover, x uniform in [1, 100];
+ * with --locality-matrix that is the row's remote percentage plus one.
+ */
+static int node_crossover(int node, int crossover){
+	if(locality_matrix.empty()){
+		return crossover;
+	}
+	return locality_matrix[node*2 + (1 - node)] + 1;
+}
+
+/*
+ * Per-op timing. Built with -DLATENCY_HIST each op (including the lock
+ * around it) is timed with the TSC into the worker's own histogram;
+ * without it both calls compile away and the loops are unchanged.
+ */
+#ifdef LATENCY_HIST
+static inline uint64_t lat_begin(){
+	return tsc_begin();
+}
+
+static inline void lat_end(thread_counter& c, int kind, uint64_t t0){
+	c.latency[kind].record(tsc_end() - t0);
+}
+#else
+static inline uint64_t lat_begin(){
+	return 0;
+}
+
+static inline void lat_end(thread_counter&, int, uint64_t){
+}
+#endif
+
+#ifdef LATENCY_HIST
+bool merged_latency(int kind, LatencyHistogram& out){
+	out.reset();
+	for(int i = 0; i < num_counters; i++){
+		out.merge(threadOps[i].latency[kind]);
+	}
+	return true;
+}
+#else
+bool merged_latency(int, LatencyHistogram&){
+	return false;
+}
+#endif
+
+static int64_t sum_thread_ops(int node){
+	int64_t sum = 0;
+	for(int i = 0; i < num_counters; i++){
+		if(threadOps[i].node.load(std::memory_order_relaxed) == node){
+			sum += threadOps[i].ops.load(std::memory_order_relaxed);
+		}
+	}
+	return sum;
+}
+
+static void reporter_loop(int interval){
+	int64_t last0 = 0;
+	int64_t last1 = 0;
+	auto next = std::chrono::steady_clock::now() + std::chrono::seconds(interval);
+	std::unique_lock<std::mutex> lk(reporter_lk);
+	while(!reporter_cv.wait_until(lk, next, []{ return reporter_stop; })){
+		int64_t now0 = sum_thread_ops(0);
+		int64_t now1 = sum_thread_ops(1);
+		globalOps0.push_back(now0 - last0);
+		globalOps1.push_back(now1 - last1);
+		last0 = now0;
+		last1 = now1;
+		next += std::chrono::seconds(interval);
+	}
+}
+
+void start_reporter(int interval){
+	for(int i = 0; i < num_counters; i++){
+		threadOps[i].ops.store(0, std::memory_order_relaxed);
+		threadOps[i].remote.store(0, std::memory_order_relaxed);
+		threadOps[i].node.store(-1, std::memory_order_relaxed);
+	}
+	reporter_stop = false;
+	reporter = new std::thread(reporter_loop, interval);
+}
+
+void stop_reporter(){
+	{
+		std::lock_guard<std::mutex> lk(reporter_lk);
+		reporter_stop = true;
+	}
+	reporter_cv.notify_one();
+	reporter->join();
+	delete reporter;
+	reporter = nullptr;
+	ops0 = sum_thread_ops(0);
+	ops1 = sum_thread_ops(1);
+	for(int n = 0; n < 2; n++){
+		pairOps[n][0] = pairOps[n][1] = 0;
+	}
+	for(int i = 0; i < num_counters; i++){
+		int n = threadOps[i].node.load(std::memory_order_relaxed);
+		if(n < 0){
+			continue;
+		}
+		int64_t remote = threadOps[i].remote.load(std::memory_order_relaxed);
+		pairOps[n][n] += threadOps[i].ops.load(std::memory_order_relaxed) - remote;
+		pairOps[n][1 - n] += remote;
+	}
+}
+
 void singleThreadedStackInit(int num_DS, bool isNuma){
-	Stacks0.resize(num_DS);
 	if(isNuma){
 		cout<<"Initializing numa stack pool"<<endl;
+		numaStacks0.resize(num_DS);
 		for(int i = 0; i < num_DS; i++)
 		{
-			Stacks0[i] = reinterpret_cast<Stack*>(new numa<Stack,0>());
+			make_ds(numaStacks0[i]);
 		}
 	}
 	else{
 		cout<<"Initializing regular stack pool"<<endl;
+		Stacks0.resize(num_DS);
 		for(int i = 0; i < num_DS; i++)
 		{
-			Stacks0[i] = new Stack();
+			make_ds(Stacks0[i]);
 		}
 	}
 }
@@ -146,38 +445,34 @@ void numa_array_init(std::string DS_config, int size, bool prefill, prefill_perc
 		Arrays1 = new char[size];
 	}
 	if(prefill){
-		for(int i = 0; i < size/int(percentages.write); i++){
-			Arrays0[i] = 'a';
-			Arrays1[i] = 'a';
-		}
+		// each worker of a node writes one contiguous chunk of that node's array
+		int fill = size/int(percentages.write);
+		workers->run([&](int node, int index, int tid){
+			char* array = (node == 0) ? Arrays0 : Arrays1;
+			int stride = workers->workers_on(node);
+			int chunk = (fill + stride - 1) / stride;
+			int begin = std::min(fill, index * chunk);
+			int end = std::min(fill, begin + chunk);
+			for(int i = begin; i < end; i++){
+				array[i] = 'a';
+			}
+		});
 	}
 }
 
-void numa_Stack_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages){
+template<typename P0, typename P1>
+static void stack_pool_init(P0& Stacks0, P1& Stacks1, int num_DS, bool prefill, prefill_percentage &percentages)
+{
 	Stacks0.resize(num_DS);
 	for(int i = 0; i < num_DS; i++)
 	{
-		if(DS_config=="numa"){
-			//cout<<"Initializing node 0 numa stack pool"<<endl;
-			Stacks0[i] = reinterpret_cast<Stack*>(new numa<Stack,0>());
-		}
-		else{
-			//cout<<"Initializing first regular stack pool"<<endl;
-			Stacks0[i] = new Stack();
-		}
+		make_ds(Stacks0[i]);
 	}
 	
 	Stacks1.resize(num_DS);
 	for(int i = 0; i < num_DS; i++)
 	{
-		if(DS_config=="numa"){
-			//cout<<"Initializing node 1 numa stack pool"<<endl;
-			Stacks1[i] = reinterpret_cast<Stack*>(new numa<Stack,1>());
-		}
-		else{
-			//cout<<"Initializing second regular stack pool"<<endl;
-			Stacks1[i] = new Stack();
-		}
+		make_ds(Stacks1[i]);
 	}
 
 	Stack_lk0.resize(num_DS);
@@ -195,53 +490,53 @@ void numa_Stack_init(std::string DS_config, int num_DS, bool prefill, prefill_pe
 		std::mt19937 gen(123);
 		std::uniform_int_distribution<> dist1(0, Stacks0.size()-1);
 		std::uniform_int_distribution<> dist2(0, Stacks0.size()-1);
-		std::uniform_int_distribution<> dist3(100, 200);
-		//Prefill in 50 % of the Stacks with random number of nodes (0-200) number of nodes
+		//Prefill a random selection of the Stacks with 200*1024 nodes each
+		std::vector<prefill_pick> picks[2];
 		for(int i = 0; i < num_DS/int(percentages.write) ; i++)
 		{
-			int ds = dist1(gen);
-			for(int j=0; j < 200*1024; j++)
-			{
-				Stack_lk0[ds]->lock();
-				Stacks0[ds]->push(ds);
-				Stack_lk0[ds]->unlock();
-			}
+			picks[0].push_back({dist1(gen), 200*1024});
 		}
 		for(int i = 0; i < num_DS/int(percentages.write) ; i++)
 		{
-			int ds = dist2(gen);
-			for(int j=0; j < 200*1024; j++)
+			picks[1].push_back({dist2(gen), 200*1024});
+		}
+		prefill_on_nodes(picks, [&](int node, const prefill_pick& pick){
+			for(int j = 0; j < pick.count; j++)
 			{
-				Stack_lk1[ds]->lock();
-				Stacks1[ds]->push(ds);
-				Stack_lk1[ds]->unlock();
+				if(node == 0){
+					Stacks0[pick.ds]->push(pick.ds);
+				}
+				else{
+					Stacks1[pick.ds]->push(pick.ds);
+				}
 			}
-		}
+		});
 	// 	std::cout<<"Prefilled " <<num_DS/int(percentages.write) <<" stacks with " << 200*1024 << " nodes each"<<std::endl;	
 	}
 }
 
-void numa_Queue_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages){
+void numa_Stack_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages){
+	if(DS_config=="numa"){
+		stack_pool_init(numaStacks0, numaStacks1, num_DS, prefill, percentages);
+	}
+	else{
+		stack_pool_init(Stacks0, Stacks1, num_DS, prefill, percentages);
+	}
+}
+
+template<typename P0, typename P1>
+static void queue_pool_init(P0& Queues0, P1& Queues1, int num_DS, bool prefill, prefill_percentage &percentages)
+{
 	Queues0.resize(num_DS);
 	for(int i = 0; i < num_DS; i++)
 	{
-		if(DS_config=="numa"){
-			Queues0[i] = reinterpret_cast<Queue*>(new numa<Queue,0>());
-		}
-		else{
-			Queues0[i] = new Queue();
-		}
+		make_ds(Queues0[i]);
 	}
 	
 	Queues1.resize(num_DS);
 	for(int i = 0; i < num_DS; i++)
 	{
-		if(DS_config=="numa"){
-			Queues1[i] = reinterpret_cast<Queue*>(new numa<Queue,1>());
-		}
-		else{
-			Queues1[i] = new Queue();
-		}
+		make_ds(Queues1[i]);
 	}
 
 	Queue_lk0.resize(num_DS);
@@ -261,46 +556,82 @@ void numa_Queue_init(std::string DS_config, int num_DS, bool prefill, prefill_pe
 		std::uniform_int_distribution<> dist2(0, Queues0.size()-1);
 		std::uniform_int_distribution<> dist3(100, 200);
 		int ds3 = dist3(gen);
-		//Prefill in 50 % of the Queue with random number of nodes (0-200) number of nodes
+		//Prefill a random selection of the Queues with 0 .. 40*1024*1024-1
+		std::vector<prefill_pick> picks[2];
 		for(int i = 0; i < num_DS/int(percentages.write) ; i++){
-			int ds = dist1(gen);
-			for(int j=0; j < 40*1024*1024; j++)
-			{
-				Queues0[ds]->add(j);
-			}
+			picks[0].push_back({dist1(gen), 40*1024*1024});
 		}
 		for(int i = 0; i < num_DS/int(percentages.write) ; i++){
-			int ds = dist2(gen);
-			for(int j=0; j < 40*1024*1024; j++)
-			{
-				Queues1[ds]->add(j);
-			}
+			picks[1].push_back({dist2(gen), 40*1024*1024});
 		}
+		prefill_on_nodes(picks, [&](int node, const prefill_pick& pick){
+			if(node == 0){
+				Queues0[pick.ds]->add_range(0, pick.count);
+			}
+			else{
+				Queues1[pick.ds]->add_range(0, pick.count);
+			}
+		});
 		//std::cout<<"Prefilled " <<num_DS/int(percentages.write) <<" queue with " << ds3 << " nodes each"<<std::endl;		
 	}
 }
 
-void numa_LL_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages){
+void numa_Queue_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages){
+	if(DS_config=="numa"){
+		queue_pool_init(numaQueues0, numaQueues1, num_DS, prefill, percentages);
+	}
+	else{
+		queue_pool_init(Queues0, Queues1, num_DS, prefill, percentages);
+	}
+}
+
+template<typename P0, typename P1>
+static void lf_pool_init(P0& Pool0, P1& Pool1, int num_DS)
+{
+	Pool0.resize(num_DS);
+	for(int i = 0; i < num_DS; i++)
+	{
+		make_ds(Pool0[i]);
+	}
+	
+	Pool1.resize(num_DS);
+	for(int i = 0; i < num_DS; i++)
+	{
+		make_ds(Pool1[i]);
+	}
+}
+
+void numa_LFStack_init(std::string DS_config, int num_DS, bool, prefill_percentage &){
+	if(DS_config=="numa"){
+		lf_pool_init(numaLFStacks0, numaLFStacks1, num_DS);
+	}
+	else{
+		lf_pool_init(LFStacks0, LFStacks1, num_DS);
+	}
+}
+
+void numa_LFQueue_init(std::string DS_config, int num_DS, bool, prefill_percentage &){
+	if(DS_config=="numa"){
+		lf_pool_init(numaLFQueues0, numaLFQueues1, num_DS);
+	}
+	else{
+		lf_pool_init(LFQueues0, LFQueues1, num_DS);
+	}
+}
+
+template<typename P0, typename P1>
+static void ll_pool_init(P0& LLs0, P1& LLs1, int num_DS, bool prefill, prefill_percentage &percentages)
+{
 	LLs0.resize(num_DS);
 	for(int i = 0; i < num_DS; i++)
 	{
-		if(DS_config=="numa"){
-			LLs0[i] = reinterpret_cast<LinkedList*>(new numa<LinkedList,0>());
-		}
-		else{
-			LLs0[i] = new LinkedList();
-		}
+		make_ds(LLs0[i]);
 	}
 	
 	LLs1.resize(num_DS);
 	for(int i = 0; i < num_DS; i++)
 	{
-		if(DS_config=="numa"){
-			LLs1[i] = reinterpret_cast<LinkedList*>(new numa<LinkedList,1>());
-		}
-		else{
-			LLs1[i] = new LinkedList();
-		}
+		make_ds(LLs1[i]);
 	}
 
 	LL_lk0.resize(num_DS);
@@ -320,33 +651,43 @@ void numa_LL_init(std::string DS_config, int num_DS, bool prefill, prefill_perce
 		std::uniform_int_distribution<> dist2(0, LLs1.size()-1);
 		std::uniform_int_distribution<> dist3(100, 200);
 		int ds3 = dist3(gen);
-		//Prefill in 50 % of the Stacks with random number of nodes (0-200) number of nodes
+		//Prefill a random selection of the lists with 100-200 nodes each
+		std::vector<prefill_pick> picks[2];
 		for(int i = 0; i < num_DS/int(percentages.write) ; i++)
 		{
 			int ds = dist1(gen);
-			for(int j=0; j < dist3(gen); j++)
-			{
-				LL_lk0[ds]->lock();
-				LLs0[ds]->append(ds);
-				LL_lk0[ds]->unlock();
-			}
-		}	
+			picks[0].push_back({ds, dist3(gen)});
+		}
 		for(int i = 0; i < num_DS/int(percentages.write) ; i++)
 		{
 			int ds = dist2(gen);
-			for(int j=0; j < dist3(gen); j++)
-			{
-				LL_lk1[ds]->lock();
-				LLs1[ds]->append(ds);
-				LL_lk1[ds]->unlock();
-			}
+			picks[1].push_back({ds, dist3(gen)});
 		}
-		std::cout<<"Prefilled " <<num_DS/int(percentages.write) <<" ll with " << dist3(gen) << " nodes each"<<std::endl;	
+		prefill_on_nodes(picks, [&](int node, const prefill_pick& pick){
+			if(node == 0){
+				LLs0[pick.ds]->append_n(pick.ds, pick.count);
+			}
+			else{
+				LLs1[pick.ds]->append_n(pick.ds, pick.count);
+			}
+		});
+		std::cout<<"Prefilled " <<num_DS/int(percentages.write) <<" ll with 100-200 nodes each"<<std::endl;	
+	}
+}
+
+void numa_LL_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages){
+	if(DS_config=="numa"){
+		ll_pool_init(numaLLs0, numaLLs1, num_DS, prefill, percentages);
+	}
+	else{
+		ll_pool_init(LLs0, LLs1, num_DS, prefill, percentages);
 	}
 }
 
 
-void numa_BST_single_init(std::string DS_config, int num_DS, int keyspace, int node, int crossover){
+template<typename P0, typename P1>
+static void bst_pool_single_init(P0& BSTs0, P1& BSTs1, int num_DS, int keyspace, int node, int crossover)
+{
 	BSTs0.resize(num_DS);
 	BSTs1.resize(num_DS);
 	BST_lk0.resize(num_DS);
@@ -354,19 +695,13 @@ void numa_BST_single_init(std::string DS_config, int num_DS, int keyspace, int n
 
 	std::mt19937 gen(123);
 	std::uniform_int_distribution<> xDist(1, 100);
-	std::uniform_int_distribution<> dist(0, keyspace/2);
+	KeyDistribution dist(key_dist, 0, keyspace/2);
 	for(int i = 0; i < num_DS; i++)
 	{
 		int x = xDist(gen);
 		
-		if(DS_config=="numa"){
-			BSTs0[i] = reinterpret_cast<BinarySearchTree*>(new numa<BinarySearchTree,0>());
-			BSTs1[i] = reinterpret_cast<BinarySearchTree*>(new numa<BinarySearchTree,1>());
-		}
-		else{
-			BSTs0[i] = new BinarySearchTree();
-			BSTs1[i] = new BinarySearchTree();
-		}
+		make_ds(BSTs0[i]);
+		make_ds(BSTs1[i]);
 	}
 
 	
@@ -388,7 +723,34 @@ void numa_BST_single_init(std::string DS_config, int num_DS, int keyspace, int n
 
 }
 
-void numa_BST_init(std::string DS_config, int num_DS, int keyspace, int node, int crossover){
+void numa_BST_single_init(std::string DS_config, int num_DS, int keyspace, int node, int crossover){
+	if(DS_name=="btree"){
+		if(DS_config=="numa"){
+			bst_pool_single_init(numaBTrees0, numaBTrees1, num_DS, keyspace, node, crossover);
+		}
+		else{
+			bst_pool_single_init(BTrees0, BTrees1, num_DS, keyspace, node, crossover);
+		}
+	}
+	else if(DS_name=="avl"){
+		if(DS_config=="numa"){
+			bst_pool_single_init(numaAVLs0, numaAVLs1, num_DS, keyspace, node, crossover);
+		}
+		else{
+			bst_pool_single_init(AVLs0, AVLs1, num_DS, keyspace, node, crossover);
+		}
+	}
+	else if(DS_config=="numa"){
+		bst_pool_single_init(numaBSTs0, numaBSTs1, num_DS, keyspace, node, crossover);
+	}
+	else{
+		bst_pool_single_init(BSTs0, BSTs1, num_DS, keyspace, node, crossover);
+	}
+}
+
+template<typename P0, typename P1>
+static void bst_pool_init(P0& BSTs0, P1& BSTs1, int num_DS, int keyspace, int node, int crossover)
+{
 	pthread_barrier_wait(&init_bar);
 	crossover = -1;
 	//std::cout<<"crossover value from here is "<<crossover<<std::endl;
@@ -398,32 +760,20 @@ void numa_BST_init(std::string DS_config, int num_DS, int keyspace, int node, in
 		BSTs1.resize(num_DS);
 		BST_lk0.resize(num_DS);
 		BST_lk1.resize(num_DS);
-		BST_reader_lk0.resize(num_DS);
-		BST_reader_lk1.resize(num_DS);
 	}
 	pthread_barrier_wait(&init_bar);
 	std::mt19937 gen(123);
 	std::uniform_int_distribution<> xDist(1, 100);
-	std::uniform_int_distribution<> dist(0, keyspace);
+	KeyDistribution dist(key_dist, 0, keyspace);
 	
 	if(node == 0){
 		for(int i = 0; i < num_DS; i++)
 		{
 			int x = xDist(gen);
 			if(x <= crossover){
-				if(DS_config=="numa"){
-					BSTs1[i] = reinterpret_cast<BinarySearchTree*>(new numa<BinarySearchTree,1>());
-				}
-				else{
-					BSTs1[i] = new BinarySearchTree();
-				}
+				make_ds(BSTs1[i]);
 			}else{
-				if(DS_config=="numa"){
-					BSTs0[i] =reinterpret_cast<BinarySearchTree*>(new numa<BinarySearchTree,0>());
-				}
-				else{
-					BSTs0[i] = new BinarySearchTree();
-				}
+				make_ds(BSTs0[i]);
 			}
 		}
 
@@ -433,10 +783,8 @@ void numa_BST_init(std::string DS_config, int num_DS, int keyspace, int node, in
 			int x = xDist(gen);
 			if(x<=crossover){
 				BST_lk1[i] = new mutex();
-				BST_reader_lk1[i] = new mutex();
 			}else{
 				BST_lk0[i] = new mutex();
-				BST_reader_lk0[i] = new mutex();
 			}
 		}
 
@@ -461,19 +809,9 @@ void numa_BST_init(std::string DS_config, int num_DS, int keyspace, int node, in
 		{
 			int x = xDist(gen);
 			if(x <= crossover){
-				if(DS_config=="numa"){
-					BSTs0[i] = reinterpret_cast<BinarySearchTree*>(new numa<BinarySearchTree,0>());
-				}
-				else{
-					BSTs0[i] = new BinarySearchTree();
-				}
+				make_ds(BSTs0[i]);
 			}else{
-				if(DS_config=="numa"){
-					BSTs1[i] = reinterpret_cast<BinarySearchTree*>(new numa<BinarySearchTree,1>());
-				}
-				else{
-					BSTs1[i] = new BinarySearchTree();
-				}
+				make_ds(BSTs1[i]);
 			}
 		}
 
@@ -508,15 +846,43 @@ void numa_BST_init(std::string DS_config, int num_DS, int keyspace, int node, in
 
 }
 
-void singleThreadedStackTest(int duration, int64_t num_DS){
-	std::mt19937 gen(123);
-	std::uniform_int_distribution<> dist(0, Stacks0.size()-1);
+void numa_BST_init(std::string DS_config, int num_DS, int keyspace, int node, int crossover){
+	if(DS_name=="btree"){
+		if(DS_config=="numa"){
+			bst_pool_init(numaBTrees0, numaBTrees1, num_DS, keyspace, node, crossover);
+		}
+		else{
+			bst_pool_init(BTrees0, BTrees1, num_DS, keyspace, node, crossover);
+		}
+	}
+	else if(DS_name=="avl"){
+		if(DS_config=="numa"){
+			bst_pool_init(numaAVLs0, numaAVLs1, num_DS, keyspace, node, crossover);
+		}
+		else{
+			bst_pool_init(AVLs0, AVLs1, num_DS, keyspace, node, crossover);
+		}
+	}
+	else if(DS_config=="numa"){
+		bst_pool_init(numaBSTs0, numaBSTs1, num_DS, keyspace, node, crossover);
+	}
+	else{
+		bst_pool_init(BSTs0, BSTs1, num_DS, keyspace, node, crossover);
+	}
+}
+
+template<typename Rng, typename P0>
+static void single_stack_test_loop(P0& Stacks0, int duration, int64_t num_DS)
+{
+	Rng gen = make_rng<Rng>(123);
+	IntRange dist(0, Stacks0.size()-1);
+	KeyDistribution dsDist(ds_dist, 0, Stacks0.size()-1);
 	//std::cout << "Thread " << tid << " about to start working on node id"<<node << std::endl;
 	int ops = 0;
 	auto startTimer = std::chrono::steady_clock::now();
 	auto endTimer = startTimer + std::chrono::seconds(duration);
 	while (std::chrono::steady_clock::now() < endTimer) {
-		int ds = dist(gen);
+		int ds = dsDist(gen);
 		int op = dist(gen)%2;
 		
 			if(op == 0){
@@ -532,15 +898,28 @@ void singleThreadedStackTest(int duration, int64_t num_DS){
 	std::cout << "OPS FOR SINGLE THREAD IS: " << ops << std::endl;
 }
 
+void singleThreadedStackTest(int duration, int64_t num_DS){
+	with_rng([&](auto tag){
+		using Rng = typename decltype(tag)::type;
+		if(DS_config=="numa"){
+			single_stack_test_loop<Rng>(numaStacks0, duration, num_DS);
+		}
+		else{
+			single_stack_test_loop<Rng>(Stacks0, duration, num_DS);
+		}
+	});
+}
+
 
 
 void ArrayTest(int tid,  int duration, int node, int64_t num_DS, int num_threads, int crossover){
 
-	int ops = 0;
+	thread_counter& counter = claim_counter(tid, node);
 	auto startTimer = std::chrono::steady_clock::now();
 	auto endTimer = startTimer + std::chrono::seconds(duration);
 	while (std::chrono::steady_clock::now() < endTimer) {
 		int x = 0;
+		uint64_t t0 = lat_begin();
 		if(node==0){
 			Array_Lk0->lock();
 			Arrays0[x] = 1;
@@ -552,25 +931,232 @@ void ArrayTest(int tid,  int duration, int node, int64_t num_DS, int num_threads
 			Arrays1[x] = 1;
 			Array_Lk1->unlock();
 		}
-		ops++;
+		lat_end(counter, 0, t0);
+		count_op(counter);
 	}
 
-	globalLK->lock();
-	if(node==0)
-	{
-		ops0 += ops;
+	pthread_barrier_wait(&bar);
+}
+
+
+/*
+ * --trace replay. Each thread copies its section of the mapped trace into
+ * memory on its own node before the start barrier, then walks it in order
+ * (wrapping around) until the duration is up. Every decision is in the
+ * records, including which pool half an op goes to, so numa and regular
+ * runs of one trace issue the same operations in the same order.
+ */
+static op_record* local_trace_section(int tid, uint64_t& count){
+	count = op_trace->header().ops_per_section;
+	size_t bytes = count * sizeof(op_record);
+	op_record* local = static_cast<op_record*>(numa_alloc_local(bytes));
+	std::memcpy(local, op_trace->section(tid), bytes);
+	return local;
+}
+
+/*
+ * Replay of a pool trace (stack, queue, ll, lf*). lk0/lk1 are the pools'
+ * locks, nullptr for the lock-free structures.
+ */
+template<typename P0, typename P1, typename Insert, typename Remove>
+static void trace_pool_loop(P0& Pool0, P1& Pool1, std::vector<mutex*>* lk0, std::vector<mutex*>* lk1, Insert insert, Remove remove, int tid, int duration, int node)
+{
+	uint64_t count;
+	op_record* ops = local_trace_section(tid, count);
+	pthread_barrier_wait(&bar);
+
+	thread_counter& counter = claim_counter(tid, node);
+	uint64_t i = 0;
+	auto endTimer = std::chrono::steady_clock::now() + std::chrono::seconds(duration);
+	while (std::chrono::steady_clock::now() < endTimer) {
+		const op_record& r = ops[i];
+		i = (i + 1 == count) ? 0 : i + 1;
+		std::vector<mutex*>* lks = (r.node == 0) ? lk0 : lk1;
+		mutex* lk = (lks != nullptr) ? (*lks)[r.ds] : nullptr;
+		uint64_t t0 = lat_begin();
+		if(lk != nullptr){
+			lk->lock();
+		}
+		if(r.node == 0){
+			if(r.op == 0){
+				insert(Pool0[r.ds], r.key);
+			}else{
+				remove(Pool0[r.ds]);
+			}
+		}
+		else{
+			if(r.op == 0){
+				insert(Pool1[r.ds], r.key);
+			}else{
+				remove(Pool1[r.ds]);
+			}
+		}
+		if(lk != nullptr){
+			lk->unlock();
+		}
+		lat_end(counter, r.op, t0);
+		count_op(counter, r.node != node);
 	}
-	else
-	{
-		ops1 += ops;
+
+	numa_free(ops, count * sizeof(op_record));
+	pthread_barrier_wait(&bar);
+}
+
+/*
+ * Replay of a bst trace: lookups honour --bst_reads, transactions lock
+ * exactly as bst_test_loop does.
+ */
+template<typename P0, typename P1>
+static void trace_bst_loop(P0& BSTs0, P1& BSTs1, int tid, int duration, int node)
+{
+	uint64_t count;
+	op_record* ops = local_trace_section(tid, count);
+	pthread_barrier_wait(&bar);
+
+	bool optimistic = (bst_reads == "optimistic");
+	auto lookup = [optimistic](auto& tree, mutex* lk, int key){
+		if(optimistic){
+			tree->optimisticLookup(key);
+		}
+		else{
+			lk->lock();
+			tree->lookup(key);
+			lk->unlock();
+		}
+	};
+
+	thread_counter& counter = claim_counter(tid, node);
+	uint64_t i = 0;
+	auto endTimer = std::chrono::steady_clock::now() + std::chrono::seconds(duration);
+	while (std::chrono::steady_clock::now() < endTimer) {
+		const op_record& r = ops[i];
+		i = (i + 1 == count) ? 0 : i + 1;
+		int kind = (r.op == 0) ? 0 : 1;
+		int lk1 = (r.ds < r.ds2) ? r.ds : r.ds2;
+		int lk2 = (r.ds < r.ds2) ? r.ds2 : r.ds;
+		uint64_t t0 = lat_begin();
+		switch(r.op){
+		case 0:
+			if(r.node == 0){
+				lookup(BSTs0[r.ds], BST_lk0[r.ds], r.key);
+			}else{
+				lookup(BSTs1[r.ds], BST_lk1[r.ds], r.key);
+			}
+			break;
+		case 1:
+			BST_lk0[r.ds]->lock();
+			BST_lk1[r.ds2]->lock();
+			BSTs0[r.ds]->remove(r.key);
+			BSTs1[r.ds2]->insert(r.key);
+			BST_lk0[r.ds]->unlock();
+			BST_lk1[r.ds2]->unlock();
+			break;
+		case 2:
+			BST_lk0[r.ds]->lock();
+			BST_lk1[r.ds2]->lock();
+			BSTs1[r.ds2]->remove(r.key);
+			BSTs0[r.ds]->insert(r.key);
+			BST_lk0[r.ds]->unlock();
+			BST_lk1[r.ds2]->unlock();
+			break;
+		case 3:
+			BST_lk0[lk1]->lock();
+			BST_lk0[lk2]->lock();
+			BSTs0[r.ds]->remove(r.key);
+			BSTs0[r.ds2]->insert(r.key);
+			BST_lk0[lk1]->unlock();
+			BST_lk0[lk2]->unlock();
+			break;
+		default:
+			BST_lk1[lk1]->lock();
+			BST_lk1[lk2]->lock();
+			BSTs1[r.ds]->remove(r.key);
+			BSTs1[r.ds2]->insert(r.key);
+			BST_lk1[lk1]->unlock();
+			BST_lk1[lk2]->unlock();
+			break;
+		}
+		lat_end(counter, kind, t0);
+		count_op(counter);
 	}
-	globalLK->unlock();
 
+	numa_free(ops, count * sizeof(op_record));
 	pthread_barrier_wait(&bar);
 }
 
+/*
+ * --batch > 1 for stack and queue. Same draws as stack_test_loop and
+ * queue_test_loop, but each draw pushes (adds) batch_size copies of ds or
+ * pops (dels) up to batch_size values. Only the pointer swap happens with
+ * the lock held: a push chain comes from build before lock() and is linked
+ * by link, a pop chain is detached by detach and read and freed after
+ * unlock(). Ops are counted per element actually pushed or popped, so a
+ * pop from an empty or short structure is not credited with batch_size
+ * elements; a latency sample covers the whole batch, allocation and free
+ * included.
+ */
+template<typename Rng, typename P0, typename P1, typename Build, typename Link, typename Detach>
+static void batch_pool_loop(P0& Pool0, P1& Pool1, std::vector<mutex*>& lk0, std::vector<mutex*>& lk1, Build build, Link link, Detach detach, int tid, int duration, int node, int crossover)
+{
+	Rng gen = make_rng<Rng>(123);
+	std::vector<int> values(batch_size);
+	std::vector<int> out(batch_size);
+	pthread_barrier_wait(&bar);
+	IntRange dist(0, Pool0.size()-1);
+	KeyDistribution dsDist(ds_dist, 0, Pool0.size()-1);
+	IntRange xDist(1, 100);
+	crossover = node_crossover(node, crossover);
 
-void StackTest(int tid,  int duration, int node, int64_t num_DS, int num_threads, int crossover)
+	thread_counter& counter = claim_counter(tid, node);
+	auto endTimer = std::chrono::steady_clock::now() + std::chrono::seconds(duration);
+	while (std::chrono::steady_clock::now() < endTimer) {
+		int ds = dsDist(gen);
+		int op = dist(gen)%2;
+		int x = xDist(gen);
+		bool onNode0 = (node==0) == (x >= crossover);
+		mutex* lk = onNode0 ? lk0[ds] : lk1[ds];
+		if(op == 0){
+			std::fill(values.begin(), values.end(), ds);
+		}
+		int elements = 0;
+		Node *chain = NULL;
+		Node *chainEnd = NULL;
+		uint64_t t0 = lat_begin();
+		if(op == 0){
+			chain = build(std::span<const int>(values), &chainEnd);
+			elements = batch_size;
+		}
+		lk->lock();
+		if(op == 0){
+			if(onNode0){
+				link(Pool0[ds], chain, chainEnd);
+			}else{
+				link(Pool1[ds], chain, chainEnd);
+			}
+		}
+		else{
+			if(onNode0){
+				chain = detach(Pool0[ds], batch_size, &elements);
+			}else{
+				chain = detach(Pool1[ds], batch_size, &elements);
+			}
+		}
+		lk->unlock();
+		for(int i = 0; op != 0 && i < elements; i++){
+			Node *next = chain->getLink();
+			out[i] = chain->getData();
+			delete chain;
+			chain = next;
+		}
+		lat_end(counter, op, t0);
+		count_op(counter, x < crossover, elements);
+	}
+
+	pthread_barrier_wait(&bar);
+}
+
+template<typename Rng, typename P0, typename P1>
+static void stack_test_loop(P0& Stacks0, P1& Stacks1, int tid,  int duration, int node, int64_t num_DS, int num_threads, int crossover)
 {	
 	#ifdef DEBUG
 	if(tid == 1 && node==0)
@@ -587,19 +1173,22 @@ void StackTest(int tid,  int duration, int node, int64_t num_DS, int num_threads
 	// printf("Thread cache enabled: %s\n", tcache ? "yes" : "no");
 	// globalLK->unlock();
 	
+    Rng gen = make_rng<Rng>(123);
 	pthread_barrier_wait(&bar);
-    std::mt19937 gen(123);
-    std::uniform_int_distribution<> dist(0, Stacks0.size()-1);
-	std::uniform_int_distribution<> xDist(1, 100);
+    IntRange dist(0, Stacks0.size()-1);
+    KeyDistribution dsDist(ds_dist, 0, Stacks0.size()-1);
+	IntRange xDist(1, 100);
+	crossover = node_crossover(node, crossover);
 	
 	//std::cout << "Thread " << tid << " about to start working on node id"<<node << std::endl;
-	int64_t ops = 0;
+	thread_counter& counter = claim_counter(tid, node);
 	auto startTimer = std::chrono::steady_clock::now();
 	auto endTimer = startTimer + std::chrono::seconds(duration);
 	while (std::chrono::steady_clock::now() < endTimer) {
-		int ds = dist(gen);
+		int ds = dsDist(gen);
 		int op = dist(gen)%2;
 		int x = xDist(gen);
+		uint64_t t0 = lat_begin();
 		if(node==0){
 			if(op == 0)
 			{
@@ -655,25 +1244,50 @@ void StackTest(int tid,  int duration, int node, int64_t num_DS, int num_threads
 				}
 			}
 		}
-		ops++;
+		lat_end(counter, op, t0);
+		count_op(counter, x < crossover);
 	}
 
 
-	globalLK->lock();
-	if(node==0)
-	{
-		ops0 += ops;
-	}
-	else
-	{
-		ops1 += ops;
-	}
-	globalLK->unlock();
 
 	pthread_barrier_wait(&bar);
 }
 
-void QueueTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover)
+void StackTest(int tid,  int duration, int node, int64_t num_DS, int num_threads, int crossover){
+	if(op_trace != nullptr){
+		auto push = [](auto& s, int v){ s->push(v); };
+		auto pop = [](auto& s){ s->pop(); };
+		if(DS_config=="numa"){
+			trace_pool_loop(numaStacks0, numaStacks1, &Stack_lk0, &Stack_lk1, push, pop, tid, duration, node);
+		}
+		else{
+			trace_pool_loop(Stacks0, Stacks1, &Stack_lk0, &Stack_lk1, push, pop, tid, duration, node);
+		}
+		return;
+	}
+	with_rng([&](auto tag){
+		using Rng = typename decltype(tag)::type;
+		if(batch_size > 1){
+			auto push = [](auto& s, Node* first, Node* last){ s->push_chain(first, last); };
+			auto pop = [](auto& s, int n, int* count){ return s->pop_chain(n, count); };
+			if(DS_config=="numa"){
+				batch_pool_loop<Rng>(numaStacks0, numaStacks1, Stack_lk0, Stack_lk1, Stack::make_chain, push, pop, tid, duration, node, crossover);
+			}
+			else{
+				batch_pool_loop<Rng>(Stacks0, Stacks1, Stack_lk0, Stack_lk1, Stack::make_chain, push, pop, tid, duration, node, crossover);
+			}
+		}
+		else if(DS_config=="numa"){
+			stack_test_loop<Rng>(numaStacks0, numaStacks1, tid, duration, node, num_DS, num_threads, crossover);
+		}
+		else{
+			stack_test_loop<Rng>(Stacks0, Stacks1, tid, duration, node, num_DS, num_threads, crossover);
+		}
+	});
+}
+
+template<typename Rng, typename P0, typename P1>
+static void queue_test_loop(P0& Queues0, P1& Queues1, int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover)
 {	
 	#ifdef DEBUG
 	if(tid == 1 && node==0)
@@ -681,16 +1295,19 @@ void QueueTest(int tid, int duration, int node, int64_t num_DS, int num_threads,
 		std::cout << "Only thread "<< tid << " will print this." << std::endl;
 	}		
 	#endif
-	std::mt19937 gen(123);
-	std::uniform_int_distribution<> dist1(0, Queues0.size()-1);
-	std::uniform_int_distribution<> xDist(1, 100);
-	int ops = 0;
+	Rng gen = make_rng<Rng>(123);
+	IntRange dist1(0, Queues0.size()-1);
+	KeyDistribution dsDist(ds_dist, 0, Queues0.size()-1);
+	IntRange xDist(1, 100);
+	crossover = node_crossover(node, crossover);
+	thread_counter& counter = claim_counter(tid, node);
 	auto startTimer = std::chrono::steady_clock::now();
 	auto endTimer = startTimer + std::chrono::seconds(duration);
 	while (std::chrono::steady_clock::now() < endTimer) {
-		int ds = dist1(gen);
+		int ds = dsDist(gen);
 		int op = dist1(gen)%2;
 		int x = xDist(gen);
+		uint64_t t0 = lat_begin();
 
 		if(node==0){
 			if(op == 0)
@@ -747,25 +1364,143 @@ void QueueTest(int tid, int duration, int node, int64_t num_DS, int num_threads,
 				}
 			}
 		}
-		ops++;
+		lat_end(counter, op, t0);
+		count_op(counter, x < crossover);
 	}
 
-	globalLK->lock();
-	if(node==0)
-	{
-		ops0 += ops;
+	pthread_barrier_wait(&bar);
+}
+
+void QueueTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover){
+	if(op_trace != nullptr){
+		auto add = [](auto& q, int v){ q->add(v); };
+		auto del = [](auto& q){ q->del(); };
+		if(DS_config=="numa"){
+			trace_pool_loop(numaQueues0, numaQueues1, &Queue_lk0, &Queue_lk1, add, del, tid, duration, node);
+		}
+		else{
+			trace_pool_loop(Queues0, Queues1, &Queue_lk0, &Queue_lk1, add, del, tid, duration, node);
+		}
+		return;
 	}
-	else
-	{
-		ops1 += ops;
+	with_rng([&](auto tag){
+		using Rng = typename decltype(tag)::type;
+		if(batch_size > 1){
+			auto add = [](auto& q, Node* first, Node* last){ q->add_chain(first, last); };
+			auto del = [](auto& q, int n, int* count){ return q->del_chain(n, count); };
+			if(DS_config=="numa"){
+				batch_pool_loop<Rng>(numaQueues0, numaQueues1, Queue_lk0, Queue_lk1, Queue::make_chain, add, del, tid, duration, node, crossover);
+			}
+			else{
+				batch_pool_loop<Rng>(Queues0, Queues1, Queue_lk0, Queue_lk1, Queue::make_chain, add, del, tid, duration, node, crossover);
+			}
+		}
+		else if(DS_config=="numa"){
+			queue_test_loop<Rng>(numaQueues0, numaQueues1, tid, duration, node, num_DS, num_threads, crossover);
+		}
+		else{
+			queue_test_loop<Rng>(Queues0, Queues1, tid, duration, node, num_DS, num_threads, crossover);
+		}
+	});
+}
+
+
+/*
+ * Shared loop for lfstack and lfqueue. Same op mix and crossover rule as
+ * stack_test_loop/queue_test_loop, but the structures are lock-free so
+ * each op is issued directly. insert/remove are the structure's push/pop
+ * (or add/del) and receive the chosen pool entry.
+ */
+template<typename Rng, typename P0, typename P1, typename Insert, typename Remove>
+static void lf_test_loop(P0& Pool0, P1& Pool1, Insert insert, Remove remove, int tid, int duration, int node, int crossover)
+{
+	Rng gen = make_rng<Rng>(123);
+	pthread_barrier_wait(&bar);
+	IntRange dist(0, Pool0.size()-1);
+	KeyDistribution dsDist(ds_dist, 0, Pool0.size()-1);
+	IntRange xDist(1, 100);
+	crossover = node_crossover(node, crossover);
+
+	thread_counter& counter = claim_counter(tid, node);
+	auto startTimer = std::chrono::steady_clock::now();
+	auto endTimer = startTimer + std::chrono::seconds(duration);
+	while (std::chrono::steady_clock::now() < endTimer) {
+		int ds = dsDist(gen);
+		int op = dist(gen)%2;
+		int x = xDist(gen);
+		uint64_t t0 = lat_begin();
+		// local pool unless this op crosses over to the other node
+		bool onNode0 = (node==0) == (x >= crossover);
+		if(op == 0){
+			if(onNode0){
+				insert(Pool0[ds], ds);
+			}else{
+				insert(Pool1[ds], ds);
+			}
+		}
+		else{
+			if(onNode0){
+				remove(Pool0[ds]);
+			}else{
+				remove(Pool1[ds]);
+			}
+		}
+		lat_end(counter, op, t0);
+		count_op(counter, x < crossover);
 	}
-	globalLK->unlock();
 
 	pthread_barrier_wait(&bar);
 }
 
+void LFStackTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover){
+	auto push = [](auto& s, int v){ s->push(v); };
+	auto pop = [](auto& s){ s->pop(); };
+	if(op_trace != nullptr){
+		if(DS_config=="numa"){
+			trace_pool_loop(numaLFStacks0, numaLFStacks1, nullptr, nullptr, push, pop, tid, duration, node);
+		}
+		else{
+			trace_pool_loop(LFStacks0, LFStacks1, nullptr, nullptr, push, pop, tid, duration, node);
+		}
+		return;
+	}
+	with_rng([&](auto tag){
+		using Rng = typename decltype(tag)::type;
+		if(DS_config=="numa"){
+			lf_test_loop<Rng>(numaLFStacks0, numaLFStacks1, push, pop, tid, duration, node, crossover);
+		}
+		else{
+			lf_test_loop<Rng>(LFStacks0, LFStacks1, push, pop, tid, duration, node, crossover);
+		}
+	});
+}
+
+void LFQueueTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover){
+	auto add = [](auto& q, int v){ q->add(v); };
+	auto del = [](auto& q){ q->del(); };
+	if(op_trace != nullptr){
+		if(DS_config=="numa"){
+			trace_pool_loop(numaLFQueues0, numaLFQueues1, nullptr, nullptr, add, del, tid, duration, node);
+		}
+		else{
+			trace_pool_loop(LFQueues0, LFQueues1, nullptr, nullptr, add, del, tid, duration, node);
+		}
+		return;
+	}
+	with_rng([&](auto tag){
+		using Rng = typename decltype(tag)::type;
+		if(DS_config=="numa"){
+			lf_test_loop<Rng>(numaLFQueues0, numaLFQueues1, add, del, tid, duration, node, crossover);
+		}
+		else{
+			lf_test_loop<Rng>(LFQueues0, LFQueues1, add, del, tid, duration, node, crossover);
+		}
+	});
+}
 
-void LinkedListTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover)
+
+template<typename Rng, typename P0, typename P1>
+static void ll_test_loop(P0& LLs0, P1& LLs1, int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover)
 {	
 	#ifdef DEBUG
 	if(tid == 1 && node==0)
@@ -774,19 +1509,22 @@ void LinkedListTest(int tid, int duration, int node, int64_t num_DS, int num_thr
 	}		
 	#endif
 
+	Rng gen = make_rng<Rng>(123);
 	pthread_barrier_wait(&bar);
-	std::mt19937 gen(123);
-	std::uniform_int_distribution<> dist(0, LLs0.size()-1);
-	std::uniform_int_distribution<> opDist(1, 100);
-	std::uniform_int_distribution<> xDist(1, 100);
+	IntRange dist(0, LLs0.size()-1);
+	KeyDistribution dsDist(ds_dist, 0, LLs0.size()-1);
+	IntRange opDist(1, 100);
+	IntRange xDist(1, 100);
+	crossover = node_crossover(node, crossover);
 	//std::cout << "Thread " << tid << " about to start working on node id"<<node << std::endl;
-	int ops = 0;
+	thread_counter& counter = claim_counter(tid, node);
 	auto startTimer = std::chrono::steady_clock::now();
 	auto endTimer = startTimer + std::chrono::seconds(duration);
 	while (std::chrono::steady_clock::now() < endTimer) {
-		int ds = dist(gen);
+		int ds = dsDist(gen);
 		int op = dist(gen)%2;
 		int x = xDist(gen);
+		uint64_t t0 = lat_begin();
 		if(node==0){
 			if(op == 0)
 			{
@@ -842,26 +1580,39 @@ void LinkedListTest(int tid, int duration, int node, int64_t num_DS, int num_thr
 				}
 			}
 		}
-		ops++;
+		lat_end(counter, op, t0);
+		count_op(counter, x < crossover);
 		
 	}
 
-	globalLK->lock();
-	if(node==0)
-	{
-		ops0 += ops;
-	}
-	else
-	{
-		ops1 += ops;
-	}
-
-	globalLK->unlock();
-
 	pthread_barrier_wait(&bar);
 }
 
-void BinarySearchTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover, int keyspace, int interval)
+void LinkedListTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover){
+	if(op_trace != nullptr){
+		auto append = [](auto& l, int v){ l->append(v); };
+		auto removeHead = [](auto& l){ l->removeHead(); };
+		if(DS_config=="numa"){
+			trace_pool_loop(numaLLs0, numaLLs1, &LL_lk0, &LL_lk1, append, removeHead, tid, duration, node);
+		}
+		else{
+			trace_pool_loop(LLs0, LLs1, &LL_lk0, &LL_lk1, append, removeHead, tid, duration, node);
+		}
+		return;
+	}
+	with_rng([&](auto tag){
+		using Rng = typename decltype(tag)::type;
+		if(DS_config=="numa"){
+			ll_test_loop<Rng>(numaLLs0, numaLLs1, tid, duration, node, num_DS, num_threads, crossover);
+		}
+		else{
+			ll_test_loop<Rng>(LLs0, LLs1, tid, duration, node, num_DS, num_threads, crossover);
+		}
+	});
+}
+
+template<typename Rng, typename P0, typename P1>
+static void bst_test_loop(P0& BSTs0, P1& BSTs1, int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover, int keyspace, int interval)
 {	
 	#ifdef DEBUG
 	if(tid == 1 && node==0)
@@ -870,43 +1621,48 @@ void BinarySearchTest(int tid, int duration, int node, int64_t num_DS, int num_t
 	}		
 	#endif
 
+	Rng gen = make_rng<Rng>(tid);
 	pthread_barrier_wait(&bar);
 	//std::cout<<"crossover value from test is "<<crossover<<std::endl;
-	std::mt19937 gen(tid);
-	std::uniform_int_distribution<> dist(0, BSTs0.size()-1);
-	std::uniform_int_distribution<> opDist(1, 100);
-	std::uniform_int_distribution<> xDist(1, 100);
-	std::uniform_int_distribution<> keyDist(0,keyspace);
+	KeyDistribution dsDist(ds_dist, 0, BSTs0.size()-1);
+	IntRange opDist(1, 100);
+	IntRange xDist(1, 100);
+	KeyDistribution keyDist(key_dist, 0, keyspace);
 
-	int64_t ops;
-	thread_local vector<int64_t> localOps;
-	localOps.resize(duration/interval);
+	// --bst_reads=optimistic: lookups skip BST_lk and validate against the
+	// tree's version counter; the remove/insert transactions still lock.
+	bool optimistic = (bst_reads == "optimistic");
+
+	thread_counter& counter = claim_counter(tid, node);
 	int x = xDist(gen);
 	auto startTimer = std::chrono::steady_clock::now();
 	auto endTimer = startTimer + std::chrono::seconds(duration);
-    auto nextLogTime = startTimer + std::chrono::seconds(interval);
-	int intervalIdx = 0;
 
 	while (duration_cast<seconds>(steady_clock::now() - startTimer).count() < duration) {
-		int ds = dist(gen);
+		int ds = dsDist(gen);
 
 
 		int key = keyDist(gen);
+		int kind = (opDist(gen)<=80) ? 0 : 1;
+		uint64_t t0 = lat_begin();
 		if(node==0){
-			if(opDist(gen)<=80)
+			if(kind == 0)
 			{
-
-				BST_lk0[ds]->lock();
-				int level = BSTs0[ds]->lookup(key);
-				// globalLK->lock();
-				// std::cout<<"Look up traversed "<<level<<" levels"<<std::endl;
-				// globalLK->unlock();
-				BST_lk0[ds]->unlock();
-			
+				if(optimistic){
+					int level = BSTs0[ds]->optimisticLookup(key);
+				}
+				else{
+					BST_lk0[ds]->lock();
+					int level = BSTs0[ds]->lookup(key);
+					// globalLK->lock();
+					// std::cout<<"Look up traversed "<<level<<" levels"<<std::endl;
+					// globalLK->unlock();
+					BST_lk0[ds]->unlock();
+				}
 			}
 			else {
-				int ds_a= dist(gen);
-				int ds_b = dist(gen);
+				int ds_a= dsDist(gen);
+				int ds_b = dsDist(gen);
 				int txn = opDist(gen);
 				if(txn%4==0){
 					BST_lk0[ds_a]->lock();
@@ -962,18 +1718,23 @@ void BinarySearchTest(int tid, int duration, int node, int64_t num_DS, int num_t
 			}
 		}
 		else{
-			if(opDist(gen)<=80)
+			if(kind == 0)
 			{
-				BST_lk1[ds]->lock();
-				int level = BSTs1[ds]->lookup(key);
-				// globalLK->lock();
-				// std::cout<<"Look up traversed "<<level<<" levels"<<std::endl;
-				// globalLK->unlock();
-				BST_lk1[ds]->unlock();
+				if(optimistic){
+					int level = BSTs1[ds]->optimisticLookup(key);
+				}
+				else{
+					BST_lk1[ds]->lock();
+					int level = BSTs1[ds]->lookup(key);
+					// globalLK->lock();
+					// std::cout<<"Look up traversed "<<level<<" levels"<<std::endl;
+					// globalLK->unlock();
+					BST_lk1[ds]->unlock();
+				}
 			}
 			else {
-				int ds_a= dist(gen);
-				int ds_b = dist(gen);
+				int ds_a= dsDist(gen);
+				int ds_b = dsDist(gen);
 				int txn = opDist(gen);
 				if(txn%4==0){
 					BST_lk0[ds_a]->lock();
@@ -1025,33 +1786,66 @@ void BinarySearchTest(int tid, int duration, int node, int64_t num_DS, int num_t
 				}
 			}
 		}
-		ops++;
-		if(std::chrono::steady_clock::now() >= nextLogTime){
-			localOps[intervalIdx] = ops;
-			intervalIdx++;
-			nextLogTime += std::chrono::seconds(interval);
-		}
+		lat_end(counter, kind, t0);
+		count_op(counter);
 	}
 
 
-	globalLK->lock();
-	if(node==0)
-	{
-		for(int i=0; i<localOps.size(); i++){
-			globalOps0[i] += localOps[i];
+
+	pthread_barrier_wait(&bar);
+}
+
+void BinarySearchTest(int tid, int duration, int node, int64_t num_DS, int num_threads, int crossover, int keyspace, int interval){
+	if(op_trace != nullptr){
+		if(DS_name=="btree"){
+			if(DS_config=="numa"){
+				trace_bst_loop(numaBTrees0, numaBTrees1, tid, duration, node);
+			}
+			else{
+				trace_bst_loop(BTrees0, BTrees1, tid, duration, node);
+			}
 		}
-		ops0 = globalOps0[globalOps0.size()-1];
-	}
-	else
-	{
-		for(int i=0; i<localOps.size(); i++){
-			globalOps1[i] += localOps[i];
+		else if(DS_name=="avl"){
+			if(DS_config=="numa"){
+				trace_bst_loop(numaAVLs0, numaAVLs1, tid, duration, node);
+			}
+			else{
+				trace_bst_loop(AVLs0, AVLs1, tid, duration, node);
+			}
+		}
+		else if(DS_config=="numa"){
+			trace_bst_loop(numaBSTs0, numaBSTs1, tid, duration, node);
+		}
+		else{
+			trace_bst_loop(BSTs0, BSTs1, tid, duration, node);
 		}
-		ops1 = globalOps1[globalOps1.size()-1];
+		return;
 	}
-	globalLK->unlock();
-
-	pthread_barrier_wait(&bar);
+	with_rng([&](auto tag){
+		using Rng = typename decltype(tag)::type;
+		if(DS_name=="btree"){
+			if(DS_config=="numa"){
+				bst_test_loop<Rng>(numaBTrees0, numaBTrees1, tid, duration, node, num_DS, num_threads, crossover, keyspace, interval);
+			}
+			else{
+				bst_test_loop<Rng>(BTrees0, BTrees1, tid, duration, node, num_DS, num_threads, crossover, keyspace, interval);
+			}
+		}
+		else if(DS_name=="avl"){
+			if(DS_config=="numa"){
+				bst_test_loop<Rng>(numaAVLs0, numaAVLs1, tid, duration, node, num_DS, num_threads, crossover, keyspace, interval);
+			}
+			else{
+				bst_test_loop<Rng>(AVLs0, AVLs1, tid, duration, node, num_DS, num_threads, crossover, keyspace, interval);
+			}
+		}
+		else if(DS_config=="numa"){
+			bst_test_loop<Rng>(numaBSTs0, numaBSTs1, tid, duration, node, num_DS, num_threads, crossover, keyspace, interval);
+		}
+		else{
+			bst_test_loop<Rng>(BSTs0, BSTs1, tid, duration, node, num_DS, num_threads, crossover, keyspace, interval);
+		}
+	});
 }
 
 
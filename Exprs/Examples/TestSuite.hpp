@@ -21,6 +21,7 @@
 #include "numathreads.hpp"
 #include <jemalloc/jemalloc.h>
 #include <umf/pools/pool_jemalloc.h>
+#include "LatencyHistogram.hpp"
 using namespace std;
 
 extern struct prefill_percentage percentages;
@@ -36,6 +37,8 @@ void numa_Stack_init(std::string DS_config, int num_DS, bool prefill, prefill_pe
 void numa_Queue_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages);
 void numa_BST_init(std::string DS_config, int num_DS, int keyspace, int node, int crossover);
 void numa_LL_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages);
+void numa_LFStack_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages);
+void numa_LFQueue_init(std::string DS_config, int num_DS, bool prefill, prefill_percentage &percentages);
 void sync_init(int num_threads);
 
 /*!
@@ -53,14 +56,65 @@ void numa_BST_single_init(std::string DS_config, int num_DS, int keyspace, int n
 
 void main_BST_test(int duration,  int64_t num_DS, int num_threads, int crossover, int keyspace);
 
+/*!
+ * \brief Test functions for the Stack and Queue pools
+ *
+ * With --batch=N above 1 every op moves up to N elements as one chain:
+ * it is built by make_chain before the lock is taken, linked by
+ * push_chain (add_chain) or detached by pop_chain (del_chain) under the
+ * lock, and freed after it is released. Ops are still counted per element.
+ */
 void StackTest(int t_id, int duration, int node, int64_t num_DS, int num_threads, int crossover);
 
 void QueueTest(int t_id, int duration, int node, int64_t num_DS, int num_threads, int crossover);
 
+/*!
+ * \brief Transaction benchmark over the BST pools, or the BPlusTree/AVLTree pools with --DS_name=btree/avl
+ *
+ * Keys are drawn from --key_dist, in the prefill as well, and the tree each
+ * operation goes to from --ds_dist (see KeyDistribution.hpp). The other
+ * test functions pick their structure from --ds_dist too.
+ *
+ * With --trace every test function instead replays its thread's section of
+ * a trace_gen file (OpTrace.hpp), copied to the thread's node first.
+ */
 void BinarySearchTest(int t_id, int duration, int node, int64_t num_DS, int num_threads, int crossover, int keyspace, int interval);
 
 void LinkedListTest(int t_id, int duration, int node, int64_t num_DS, int num_threads, int crossover);
 
+/*!
+ * \brief Test functions for the lock-free Stack and Queue (--DS_name=lfstack/lfqueue)
+ *
+ * Same op mix as StackTest/QueueTest without the per-structure mutexes.
+ */
+void LFStackTest(int t_id, int duration, int node, int64_t num_DS, int num_threads, int crossover);
+
+void LFQueueTest(int t_id, int duration, int node, int64_t num_DS, int num_threads, int crossover);
+
+/*!
+ * \brief Start/stop the interval reporter for one run
+ *
+ * start_reporter() zeroes the per-thread op counters and samples them every
+ * interval seconds into globalOps0/1 (ops completed on each node during that
+ * interval). stop_reporter() joins the sampler and sets ops0/ops1 to the
+ * run's totals, and pairOps[n][m] to the ops workers on node index n ran
+ * on node m's half. Call start before spawning the workers, stop after
+ * joining.
+ */
+void start_reporter(int interval);
+
+void stop_reporter();
+
+/*!
+ * \brief Merge every worker's latency histogram for one op kind
+ *
+ * kind 0 is push/add/append/lookup (and the array write), kind 1 is
+ * pop/del/removeHead/the BST transaction. Values are TSC cycles.
+ *
+ * \return false if the harness was built without -DLATENCY_HIST.
+ */
+bool merged_latency(int kind, LatencyHistogram& out);
+
 void global_cleanup();
 
 #endif 
\ No newline at end of file
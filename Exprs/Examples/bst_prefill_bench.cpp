@@ -0,0 +1,107 @@
+/*! \file bst_prefill_bench.cpp
+ * \brief Time to prefill a pool of numa BSTs, serially or through numa_scheduler.
+ *
+ * Trees alternate between numa_ref<BinarySearchTree,0> and <1>. In "single"
+ * mode the main thread inserts every key; in "sched" mode each tree's
+ * inserts are one task handed to submit_near(tree), so the worker that
+ * fills a tree sits on the node the tree header was placed on and idle
+ * nodes steal what is left.
+ *
+ * Usage: bst_prefill_bench <single|sched> [num_DS] [keyspace] [threads_per_node]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include "numatype.hpp"
+#include "numathreads.hpp"
+#include "numasched.hpp"
+#include "BinarySearch.hpp"
+
+using namespace std;
+
+int keyspace = 1000;
+
+std::vector<numa_ref<BinarySearchTree,0>> trees0;
+std::vector<numa_ref<BinarySearchTree,1>> trees1;
+
+static void fill(BinarySearchTree* tree, int seed){
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<> dist(0, keyspace);
+    for(int k = 0; k < keyspace / 2; k++){
+        tree->insert(dist(gen));
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <single|sched> [num_DS] [keyspace] [threads_per_node]\n";
+        return 1;
+    }
+
+    std::string mode = argv[1];
+    int num_DS = (argc > 2) ? std::stoi(argv[2]) : 1000;
+    if (argc > 3) {
+        keyspace = std::stoi(argv[3]);
+    }
+    int threads_per_node = (argc > 4) ? std::stoi(argv[4]) : 0;
+
+    if (mode != "single" && mode != "sched") {
+        std::cout << "Unknown option: " << mode << "\n";
+        return 1;
+    }
+
+    for(int i = 0; i < num_DS; i++){
+        if(i % 2 == 0){
+            trees0.push_back(numa_ref<BinarySearchTree,0>::make());
+        }
+        else{
+            trees1.push_back(numa_ref<BinarySearchTree,1>::make());
+        }
+    }
+
+    // the scheduler's threads are started outside the timed region
+    numa_scheduler* sched = nullptr;
+    if (mode == "sched") {
+        sched = new numa_scheduler(numa_topology::nodes(), threads_per_node);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (mode == "single") {
+        for(size_t i = 0; i < trees0.size(); i++){
+            fill(trees0[i].get(), 2*i);
+        }
+        for(size_t i = 0; i < trees1.size(); i++){
+            fill(trees1[i].get(), 2*i+1);
+        }
+    }
+    else {
+        for(size_t i = 0; i < trees0.size(); i++){
+            BinarySearchTree* tree = trees0[i].get();
+            sched->submit_near(tree, [tree, i] { fill(tree, 2*i); });
+        }
+        for(size_t i = 0; i < trees1.size(); i++){
+            BinarySearchTree* tree = trees1[i].get();
+            sched->submit_near(tree, [tree, i] { fill(tree, 2*i+1); });
+        }
+        sched->wait();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    int workers = sched ? sched->num_workers() : 1;
+    delete sched;
+
+    for(auto& t : trees0){
+        t.destroy();
+    }
+    for(auto& t : trees1){
+        t.destroy();
+    }
+
+    // mode, workers, num_DS, keyspace, prefill_ms
+    std::cout << mode << ", " << workers << ", " << num_DS << ", " << keyspace << ", " << ms << "\n";
+}
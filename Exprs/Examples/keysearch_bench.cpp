@@ -0,0 +1,147 @@
+/*! \file keysearch_bench.cpp
+ * \brief Lookup cost of the KeySearch.hpp kernels against a getData() compare chain.
+ *
+ * Every method answers the same random queries against the same sorted
+ * keys and reports ns per query:
+ *   chain   binary search over BinaryNode objects, comparing getData()
+ *           with early exit, the per-level pattern of BinarySearchTree::lookup
+ *           (its checksum differs from lower/batch when keys repeat, since
+ *           it stops at any equal key rather than the first)
+ *   lower   key_search::lower_bound over a sorted int array
+ *   batch   key_search::lower_bound_batch over the same array
+ *   node16  one 16-key line: getData() scan vs. key_search::count_less16
+ *           (node16_chain / node16_simd)
+ *
+ * Built twice by the Makefile: bin/keysearch_bench with the SIMD kernel the
+ * target allows, bin/keysearch_bench_scalar with -DKEY_SEARCH_SCALAR.
+ *
+ * Usage: keysearch_bench [num_keys] [num_queries]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "BinaryNode.hpp"
+#include "KeySearch.hpp"
+
+using namespace std;
+
+int num_keys = 1 << 20;
+int num_queries = 1 << 22;
+
+static int chain_search(BinaryNode* nodes, int n, int key){
+    int lo = 0;
+    int hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (nodes[mid].getData() == key) {
+            return mid;
+        }
+        if (key < nodes[mid].getData()) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static int chain_count16(BinaryNode* line, int key){
+    int pos = 0;
+    while (pos < 16 && line[pos].getData() < key) {
+        pos++;
+    }
+    return pos;
+}
+
+template<typename Fn>
+static void report(const char* method, int n, Fn fn){
+    auto start = std::chrono::steady_clock::now();
+    int64_t checksum = fn();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    // kernel, method, num_keys, num_queries, ns_per_query, checksum
+    std::cout << key_search::kernel_name << ", " << method << ", " << n << ", " << num_queries << ", "
+              << ns / num_queries << ", " << checksum << "\n";
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc > 1) {
+        num_keys = std::stoi(argv[1]);
+    }
+    if (argc > 2) {
+        num_queries = std::stoi(argv[2]);
+    }
+
+    std::mt19937 gen(123);
+    std::uniform_int_distribution<> keyDist(0, 4 * num_keys);
+    std::vector<int> keys(num_keys);
+    for (int& k : keys) {
+        k = keyDist(gen);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<BinaryNode> nodes;
+    nodes.reserve(num_keys);
+    for (int k : keys) {
+        nodes.emplace_back(k);
+    }
+    std::vector<int> queries(num_queries);
+    for (int& q : queries) {
+        q = keyDist(gen);
+    }
+    std::vector<int> out(num_queries);
+
+    report("chain", num_keys, [&]{
+        int64_t sum = 0;
+        for (int q : queries) {
+            sum += chain_search(nodes.data(), num_keys, q);
+        }
+        return sum;
+    });
+
+    report("lower", num_keys, [&]{
+        int64_t sum = 0;
+        for (int q : queries) {
+            sum += key_search::lower_bound(keys.data(), num_keys, q);
+        }
+        return sum;
+    });
+
+    report("batch", num_keys, [&]{
+        key_search::lower_bound_batch(keys.data(), num_keys, queries.data(), num_queries, out.data());
+        int64_t sum = 0;
+        for (int o : out) {
+            sum += o;
+        }
+        return sum;
+    });
+
+    // a single node-sized line, always in L1: the pure compare cost
+    int line[16];
+    BinaryNode lineNodes[16];
+    for (int i = 0; i < 16; i++) {
+        line[i] = keys[(int64_t)i * num_keys / 16];
+        lineNodes[i] = BinaryNode(line[i]);
+    }
+
+    report("node16_chain", 16, [&]{
+        int64_t sum = 0;
+        for (int q : queries) {
+            sum += chain_count16(lineNodes, q);
+        }
+        return sum;
+    });
+
+    report("node16_simd", 16, [&]{
+        int64_t sum = 0;
+        for (int q : queries) {
+            sum += key_search::count_less16(line, q);
+        }
+        return sum;
+    });
+}
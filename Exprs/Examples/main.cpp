@@ -20,9 +20,10 @@
 #include <chrono>
 #include <iomanip>
 #include <unordered_map>
+#include "KeyDistribution.hpp"
+#include "OpTrace.hpp"
 
 
-#define NUMA_NODES 4
 using namespace std;
 
 
@@ -37,6 +38,15 @@ int crossover = 0;
 int keyspace = 80000;
 int run_freq = 1;
 int interval =20;
+std::string bst_reads = "locked";
+std::string key_dist = "uniform";
+std::string ds_dist = "uniform";
+std::string rng_name = "mt19937";
+int64_t rng_stream = 0;
+op_trace_file* op_trace = nullptr;
+// --locality-matrix, row-major [thread node][memory node] percentages; empty = use crossover
+std::vector<int> locality_matrix;
+int batch_size = 1;
 struct prefill_percentage{
 	float write;
 	float read;
@@ -47,25 +57,20 @@ struct prefill_percentage{
 
 extern int64_t ops0;
 extern int64_t ops1;
+extern int64_t pairOps[2][2];
 extern std::vector<int64_t> globalOps0;
 extern std::vector<int64_t> globalOps1;
 
 std::vector <int64_t> num_ops1;
 std::vector <int64_t> num_ops0;
 std::vector <int64_t> total_ops;
+std::vector <double> init_times;
 
 
 
-std::vector <thread_numa<0>*> numa_thread0;
-std::vector <thread_numa<1>*> numa_thread1;
-std::vector <thread*> regular_thread0;
-std::vector <thread*> regular_thread1;
-thread_numa<0>* init_thread0;
-thread_numa<1>* init_thread1;
-std::thread* init_thread_regular0;
-std::thread* init_thread_regular1;
+numa_thread_pool* workers;
 
-void print_function(int duration, int64_t ops0, int64_t ops1, int64_t totalOps){
+void print_prefix(int duration){
 	auto now = std::chrono::system_clock::now();
     std::time_t now_time = std::chrono::system_clock::to_time_t(now);
     std::tm* local_time = std::localtime(&now_time);
@@ -79,11 +84,141 @@ void print_function(int duration, int64_t ops0, int64_t ops1, int64_t totalOps){
 	std::cout<<duration << ", ";
 	std::cout<<keyspace<<", ";
 	std::cout<<interval<<", ";
+}
+
+void print_function(int duration, int64_t ops0, int64_t ops1, int64_t totalOps){
+	print_prefix(duration);
 	std::cout<<ops0 << ", ";
 	std::cout<<ops1 << ", ";
 	std::cout<<totalOps << "\n";
 }
 
+/*
+ * With -DLATENCY_HIST: one row per op kind after the time series, with the
+ * same leading columns as print_function followed by
+ * op, count, p50_ns, p99_ns, p99.9_ns, max_ns. Prints nothing otherwise.
+ */
+void print_latency(int duration){
+	const char* names[2] = {"insert", "remove"};
+	if(DS_name == "stack" || DS_name == "lfstack"){
+		names[0] = "push"; names[1] = "pop";
+	}
+	else if(DS_name == "queue" || DS_name == "lfqueue"){
+		names[0] = "add"; names[1] = "del";
+	}
+	else if(DS_name == "ll"){
+		names[0] = "append"; names[1] = "removeHead";
+	}
+	else if(DS_name == "bst" || DS_name == "btree" || DS_name == "avl"){
+		names[0] = "lookup"; names[1] = "transaction";
+	}
+	else if(DS_name == "array"){
+		names[0] = "write"; names[1] = "none";
+	}
+
+	LatencyHistogram hist;
+	for(int kind = 0; kind < 2; kind++){
+		if(!merged_latency(kind, hist) || hist.getCount() == 0){
+			continue;
+		}
+		double tpn = tsc_per_ns();
+		print_prefix(duration);
+		std::cout<<names[kind] << ", ";
+		std::cout<<hist.getCount() << ", ";
+		std::cout<<(int64_t)(hist.percentile(50.0) / tpn) << ", ";
+		std::cout<<(int64_t)(hist.percentile(99.0) / tpn) << ", ";
+		std::cout<<(int64_t)(hist.percentile(99.9) / tpn) << ", ";
+		std::cout<<(int64_t)(hist.getMax() / tpn) << "\n";
+	}
+}
+
+/*
+ * With --locality-matrix: one row per (thread node, memory node) pair after
+ * the time series, with the same leading columns as print_function followed
+ * by pair, thread node, memory node, configured percent, ops.
+ */
+void print_locality(int duration){
+	if(locality_matrix.empty()){
+		return;
+	}
+	for(int n = 0; n < 2; n++){
+		for(int m = 0; m < 2; m++){
+			print_prefix(duration);
+			std::cout<<"pair, ";
+			std::cout<<n << ", ";
+			std::cout<<m << ", ";
+			std::cout<<locality_matrix[n*2 + m] << ", ";
+			std::cout<<pairOps[n][m] << "\n";
+		}
+	}
+}
+
+/*
+ * Parse --locality-matrix: 2x2 comma-separated percentages, row-major, row
+ * n giving where ops of the workers on node index n go. Each row sums to 100.
+ */
+bool parse_locality_matrix(const std::string& optarg, std::vector<int>& matrix) {
+	std::istringstream stream(optarg);
+	std::string value;
+	matrix.clear();
+	while (std::getline(stream, value, ',')) {
+		try {
+			matrix.push_back(std::stoi(value));
+		} catch (const std::logic_error& e) {
+			std::cerr << "Invalid percentage value: " << value << std::endl;
+			return false;
+		}
+	}
+	if (matrix.size() != 4) {
+		std::cerr << "Error: --locality-matrix requires 4 comma-separated values (2 thread nodes x 2 memory nodes)." << std::endl;
+		return false;
+	}
+	for (int n = 0; n < 2; n++) {
+		if (matrix[n*2] < 0 || matrix[n*2 + 1] < 0 || matrix[n*2] + matrix[n*2 + 1] != 100) {
+			std::cerr << "Error: --locality-matrix row " << n << " must be two non-negative percentages summing to 100." << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Wall time of one pool init (allocation plus prefill), appended to init_times.
+ */
+template<typename InitFn>
+void timed_init(InitFn init){
+	auto start = std::chrono::steady_clock::now();
+	init();
+	auto end = std::chrono::steady_clock::now();
+	init_times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+/*
+ * One row after the time series with the same leading columns as
+ * print_function followed by "init" and the mean init time in ms
+ * (the mean over run_freq runs for bst).
+ */
+void print_init_time(int duration){
+	if(init_times.empty()){
+		return;
+	}
+	double sum = 0;
+	for(double ms : init_times){
+		sum += ms;
+	}
+	print_prefix(duration);
+	std::cout<<"init, ";
+	std::cout<<sum / init_times.size() << "\n";
+}
+
+void print_time_series(){
+	int elapsed = interval;
+	for(int i = 0; i < globalOps0.size(); i++){
+		print_function(elapsed, globalOps0[i], globalOps1[i], globalOps0[i] + globalOps1[i]);
+		elapsed += interval;
+	}
+}
+
 bool parse_prefill(const std::string& optarg, prefill_percentage& percentages) {
     std::istringstream stream(optarg);
     std::string value;
@@ -114,111 +249,58 @@ bool parse_prefill(const std::string& optarg, prefill_percentage& percentages) {
 }
 
 
-void main_BST_test(int duration, int64_t num_DS, int num_threads, int crossover, int keyspace){
-	#ifdef PIN_INIT
-			init_thread0 = new thread_numa<0>(numa_BST_init, DS_config, num_DS/2, keyspace, 0,crossover);
-			init_thread1 = new thread_numa<1>(numa_BST_init, DS_config, num_DS/2, keyspace, 1,crossover);
-			// std::cout<< "multi threaded initialization running" <<std::endl;
-			// init_thread_regular0 = new thread(numa_BST_single_init, DS_config, num_DS/2, keyspace, 0, crossover);
-			// init_thread_regular1 = new thread(numa_BST_single_init, DS_config, num_DS/2, keyspace, 1, crossover);
-			if(init_thread0 != nullptr){
-				init_thread0->join();
-			}
-			
-			if(init_thread1 != nullptr){
-				init_thread1->join();
-			}
-			// if(init_thread_regular0 != nullptr){
-			// 	init_thread_regular0->join();
-			// }
-
-			// if(init_thread_regular1 != nullptr){
-			// 	init_thread_regular1->join();
-			// }
-			
-			// if(init_thread0 != nullptr){
-			// 	init_thread0->join();
-			// }
-			
-			// if(init_thread1 != nullptr){
-			// 	init_thread1->join();
-			// }
-		#else
-			// std::cout<< "single threaded initialization running" <<std::endl;
-			numa_BST_single_init(DS_config, num_DS/2, keyspace, -1, crossover);
-		#endif
 
-		
-		for(int i=0; i < num_threads/2; i++){
-			int node = 0;
-			int tid = i;
-			if(thread_config == "numa"){
-				numa_thread0[i] = new thread_numa<0>(BinarySearchTest,tid, duration, node, num_DS/2, num_threads/2, crossover, keyspace, interval);
-			}
-			else if(thread_config == "regular"){
-				regular_thread0[i] = new thread(BinarySearchTest,tid, duration, node, num_DS/2, num_threads/2, crossover, keyspace, interval);
-			}
-			else{
-				numa_thread0[i] = new thread_numa<0>(BinarySearchTest, tid, duration, 1, num_DS/2, num_threads/2, crossover, keyspace, interval);
-			}
-		}
-		for(int i=0; i < num_threads/2; i++){
-			int node = 1;
-			int tid = i + num_threads/2;
-			if(thread_config == "numa"){
-				numa_thread1[i] = new thread_numa<1>(BinarySearchTest,tid, duration, node, num_DS/2, num_threads/2, crossover,keyspace, interval);
-			}
-			else if(thread_config == "regular"){
-				regular_thread1[i] = new thread(BinarySearchTest,tid, duration, node, num_DS/2, num_threads/2, crossover,keyspace, interval);
-			}
-			else{
-				numa_thread1[i] = new thread_numa<1>(BinarySearchTest, tid, duration, 0, num_DS/2, num_threads/2, crossover, keyspace, interval);
-			}
-		}
+/*
+ * Every pool of data structures has a node-0 and a node-1 half, so the
+ * harness always runs on two node indices. They map to the first two nodes
+ * libnuma reports; on a single-node machine both map to node 0 so the
+ * harness still runs (without any remote accesses).
+ */
+std::vector<int> harness_nodes(){
+	std::vector<int> nodes = numa_topology::nodes();
+	if(nodes.size() < 2){
+		std::cerr << "Only one NUMA node found; running both halves on node " << nodes[0] << std::endl;
+		return {nodes[0], nodes[0]};
+	}
+	return {nodes[0], nodes[1]};
+}
 
-		if(thread_config == "numa"){
-			for(int i=0; i < num_threads/2; i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < num_threads/2; i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
-		else if(thread_config == "regular"){
-			for(int i=0; i < regular_thread0.size(); i++){
-				if(regular_thread0[i] == nullptr){
-					continue;
-				}
-				regular_thread0[i]->join();
-			}
-			for(int i=0; i < regular_thread1.size(); i++){
-				if(regular_thread1[i] == nullptr){
-					continue;
-				}
-				regular_thread1[i]->join();
-			}
-		}
-		else{
-			for(int i=0; i < numa_thread0.size(); i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < numa_thread1.size(); i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
+/*
+ * Run one of the (tid, duration, node, num_DS, num_threads, crossover) test
+ * functions on every worker and wait. With th_config=numa/regular each
+ * worker works on its own node's half; any other th_config alternates the
+ * half by worker index while the worker stays pinned to its node.
+ */
+template<typename TestFn>
+void run_node_test(TestFn test, int duration, int64_t num_DS, int num_threads, int crossover){
+	workers->run([&](int node, int index, int tid){
+		int ds_node = (thread_config == "numa" || thread_config == "regular") ? node : index%2;
+		test(tid, duration, ds_node, num_DS/2, num_threads/2, crossover);
+	});
+}
 
+void main_BST_test(int duration, int64_t num_DS, int num_threads, int crossover, int keyspace){
+	timed_init([&]{
+	#ifdef PIN_INIT
+		// one pinned init thread per node, whatever th_config is
+		numa_thread_pool init_pool(harness_nodes(), 1, true);
+		init_pool.run_per_node([&](int node){
+			numa_BST_init(DS_config, num_DS/2, keyspace, node, crossover);
+		});
+	#else
+		// std::cout<< "single threaded initialization running" <<std::endl;
+		numa_BST_single_init(DS_config, num_DS/2, keyspace, -1, crossover);
+	#endif
+	});
+
+		start_reporter(interval);
+		// the mixed th_config runs each node's workers on the other node's trees
+		workers->run([&](int node, int, int tid){
+			int ds_node = (thread_config == "numa" || thread_config == "regular") ? node : 1 - node;
+			BinarySearchTest(tid, duration, ds_node, num_DS/2, num_threads/2, crossover, keyspace, interval);
+		});
+
+		stop_reporter();
 		num_ops0.push_back(ops0);
 		num_ops1.push_back(ops1);
 		total_ops.push_back(ops0 + ops1);
@@ -235,7 +317,7 @@ int main(int argc, char *argv[])
 	static struct option long_options[] = {
 		{"th_config", required_argument, nullptr, 'c'},     // --th_config=NUMA/REGULAR
 		{"DS_config", required_argument, nullptr, 'd'},     // --DS_config=NUMA/REGULAR
-		{"DS_name", required_argument, nullptr, 's'},       // --DS_name=STACK/QUEUE
+		{"DS_name", required_argument, nullptr, 's'},       // --DS_name=STACK/QUEUE/LFSTACK/LFQUEUE/BST/BTREE/AVL
 		{"num_DS", required_argument, nullptr, 'n'},        // -n
 		{"num_threads", required_argument, nullptr, 't'},   // -t
 		{"duration", required_argument, nullptr, 'D'},      // -d
@@ -243,11 +325,21 @@ int main(int argc, char *argv[])
 		{"crossover", optional_argument, nullptr, 'x'},       // -x
 		{"keyspace", required_argument, nullptr, 'k'},      // -k
 		{"interval", required_argument, nullptr, 'i'},      // -i
+		{"bst_reads", required_argument, nullptr, 'r'},     // --bst_reads=locked/optimistic
+		{"prefill", required_argument, nullptr, 'p'},       // --prefill=write,read,remove,update
+		{"key_dist", required_argument, nullptr, 'K'},      // --key_dist=SPEC, keys of bst/btree/avl (KeyDistribution.hpp)
+		{"ds_dist", required_argument, nullptr, 'S'},       // --ds_dist=SPEC, structure each op goes to
+		{"rng", required_argument, nullptr, 'R'},           // --rng=mt19937/xoshiro/wyrand, generator of the test loops
+		{"rng_stream", required_argument, nullptr, 'T'},    // --rng_stream=N, pre-generate N values per thread (0 = draw live)
+		{"trace", required_argument, nullptr, 'X'},         // --trace=FILE, replay a trace_gen trace instead of drawing ops
+		{"locality-matrix", required_argument, nullptr, 'L'}, // --locality-matrix=p00,p01,p10,p11, replaces -x per thread node
+		{"batch", required_argument, nullptr, 'B'},         // --batch=N, stack/queue elements per push_chain/pop_chain (1 = single ops)
 		{nullptr, 0, nullptr, 0}                            // End of array
 	};
 
  int opt;
     int option_index = 0;
+	std::string trace_path;
 
     while ((opt = getopt_long(argc, argv, "n:t:D:x:k:f:i:", long_options, &option_index)) != -1) {
         switch (opt) {
@@ -291,6 +383,54 @@ int main(int argc, char *argv[])
 					keyspace = std::stoi(optarg);
 				}
 				break;
+			case 'r':  // --bst_reads option
+				bst_reads = optarg;
+				break;
+			case 'p':  // --prefill option
+				if(!parse_prefill(optarg, percentages)){
+					return 1;
+				}
+				prefill_set = int(percentages.write) > 0;  // the inits pick num_DS/int(write) structures
+				break;
+			case 'K':  // --key_dist option
+				key_dist = optarg;
+				if(!KeyDistribution::known(key_dist)){
+					std::cerr << "Unknown key distribution: " << key_dist << "\n";
+					return 1;
+				}
+				break;
+			case 'R':  // --rng option
+				rng_name = optarg;
+				if(rng_name != "mt19937" && rng_name != "xoshiro" && rng_name != "wyrand"){
+					std::cerr << "Unknown generator: " << rng_name << "\n";
+					return 1;
+				}
+				break;
+			case 'T':  // --rng_stream option
+				rng_stream = std::stoll(optarg);
+				break;
+			case 'L':  // --locality-matrix option
+				if(!parse_locality_matrix(optarg, locality_matrix)){
+					return 1;
+				}
+				break;
+			case 'B':  // --batch option
+				batch_size = std::stoi(optarg);
+				if(batch_size < 1){
+					std::cerr << "--batch must be at least 1\n";
+					return 1;
+				}
+				break;
+			case 'X':  // --trace option
+				trace_path = optarg;
+				break;
+			case 'S':  // --ds_dist option
+				ds_dist = optarg;
+				if(!KeyDistribution::known(ds_dist)){
+					std::cerr << "Unknown structure distribution: " << ds_dist << "\n";
+					return 1;
+				}
+				break;
             case '?':  // Unknown option
                 std::cerr << "Unknown option or missing argument.\n";
                 return 1;
@@ -299,13 +439,53 @@ int main(int argc, char *argv[])
         }
     }
 
+	if(!trace_path.empty()){
+		std::string error;
+		op_trace = new op_trace_file();
+		if(!op_trace->open(trace_path, error)){
+			std::cerr << error << "\n";
+			return 1;
+		}
+		if(!locality_matrix.empty()){
+			std::cerr << "--locality-matrix has no effect with --trace; the trace fixes each op's node\n";
+			return 1;
+		}
+		if(batch_size > 1){
+			std::cerr << "--batch has no effect with --trace; traces replay single ops\n";
+			return 1;
+		}
+		const op_trace_header& h = op_trace->header();
+		bool pool = (DS_name == "stack" || DS_name == "queue" || DS_name == "ll" || DS_name == "lfstack" || DS_name == "lfqueue");
+		bool tree = (DS_name == "bst" || DS_name == "btree" || DS_name == "avl");
+		if(!(pool && h.kind == OP_TRACE_POOL) && !(tree && h.kind == OP_TRACE_BST)){
+			std::cerr << trace_path << " is not a trace for --DS_name=" << DS_name << "\n";
+			return 1;
+		}
+		if(int64_t(h.ds_per_node) != num_DS/2){
+			std::cerr << trace_path << " was generated for num_DS=" << 2*int64_t(h.ds_per_node) << ", not " << num_DS << "\n";
+			return 1;
+		}
+		if(tree && int(h.keyspace) != keyspace){
+			std::cerr << trace_path << " was generated for keyspace=" << h.keyspace << ", not " << keyspace << "\n";
+			return 1;
+		}
+	}
+
 	print_function(0, 0 ,0, 0);
     
 	// std::cout<<endl;
-	numa_thread0.resize(num_threads);
-	numa_thread1.resize(num_threads);
-	regular_thread0.resize(num_threads);
-	regular_thread1.resize(num_threads);
+	// -t splits evenly over the two node indices, an odd count rounded up
+	// (0 workers per node would mean one per CPU); without -t every CPU of
+	// both nodes gets a worker. th_config=regular leaves workers unpinned.
+	int threads_per_node = 0;
+	if(num_threads > 0){
+		threads_per_node = std::max(1, (num_threads + 1)/2);
+		if(2*threads_per_node != num_threads){
+			std::cerr << "-t " << num_threads << " rounded up to " << 2*threads_per_node << " threads, one half per node index\n";
+		}
+	}
+	workers = new numa_thread_pool(harness_nodes(), threads_per_node, thread_config != "regular");
+	num_threads = workers->num_workers();
 	global_init(num_threads, duration, interval);
 	
 	// // #ifdef UMF
@@ -333,250 +513,81 @@ int main(int argc, char *argv[])
 	// singleThreadedStackTest(duration, num_DS);
 	// std::cout<<"percentage write = "<< percentages.write <<std::endl;
 	if(DS_name == "array"){
-		numa_array_init(DS_config, num_DS/2, prefill_set, percentages);
-
-		for(int i=0; i < num_threads/2; i++){
-			int node = 0;
-			int tid = i;
-			if(thread_config == "numa"){
-				numa_thread0[i] = new thread_numa<0>(ArrayTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else if(thread_config == "regular"){
-				regular_thread0[i] = new thread(ArrayTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else{
-				numa_thread0[i] = new thread_numa<0>(ArrayTest, tid, duration, i%2, num_DS/2, num_threads/2, crossover);
-			}
-		}
-
-		for(int i=0; i < num_threads/2; i++){
-			int node = 1;
-			int tid = i + num_threads/2;
-			if(thread_config == "numa"){
-				numa_thread1[i] = new thread_numa<1>(ArrayTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else if(thread_config == "regular"){
-				regular_thread1[i] = new thread(ArrayTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else{
-				numa_thread1[i] = new thread_numa<1>(ArrayTest, tid, duration, i%2, num_DS/2, num_threads/2, crossover);
-			}
-		}
-
-		if(thread_config == "numa"){
-			for(int i=0; i < num_threads/2; i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < num_threads/2; i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
-		else if(thread_config == "regular"){
-			for(int i=0; i < regular_thread0.size(); i++){
-				if(regular_thread0[i] == nullptr){
-					continue;
-				}
-				regular_thread0[i]->join();
-			}
-			for(int i=0; i < regular_thread1.size(); i++){
-				if(regular_thread1[i] == nullptr){
-					continue;
-				}
-				regular_thread1[i]->join();
-			}
-		}
-		else{
-			for(int i=0; i < numa_thread0.size(); i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < numa_thread1.size(); i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
-
-		for(int i :globalOps0){
-			std::cout << i << ", ";
-		}
-		for(int i :globalOps1){
-			std::cout << i << ", ";
-		}
+		timed_init([&]{ numa_array_init(DS_config, num_DS/2, prefill_set, percentages); });
+		start_reporter(interval);
+		run_node_test(ArrayTest, duration, num_DS, num_threads, crossover);
+
+		stop_reporter();
+		print_time_series();
+		print_latency(duration);
+		print_init_time(duration);
 		std::cout << ops0 << ", ";
 		std::cout << ops1 << ", ";
 		std::cout << ops0 + ops1 << "\n";
 	}
 	else if(DS_name == "stack"){
-		numa_Stack_init(DS_config, num_DS/2, prefill_set, percentages);
-
-		for(int i=0; i < num_threads/2; i++){
-			int node = 0;
-			int tid = i;
-			if(thread_config == "numa"){
-				numa_thread0[i] = new thread_numa<0>(StackTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else if(thread_config== "regular"){
-				regular_thread0[i] = new thread(StackTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else{
-				numa_thread0[i] = new thread_numa<0>(StackTest, tid, duration, i%2, num_DS/2, num_threads/2, crossover);
-			}
-		}
-		for(int i=0; i < num_threads/2; i++){
-			int node = 1;
-			int tid = i + num_threads/2;
-
-			if(thread_config == "numa"){
-				numa_thread1[i] = new thread_numa<1>(StackTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else if(thread_config== "regular"){
-				regular_thread1[i] = new thread(StackTest, tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else{
-				numa_thread1[i] = new thread_numa<1>(StackTest, tid, duration, i%2, num_DS/2, num_threads/2, crossover);
-			}
-		}
-
-		if(thread_config == "numa"){
-			for(int i=0; i < num_threads/2; i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < num_threads/2; i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
-		else if(thread_config == "regular"){
-			for(int i=0; i < regular_thread0.size(); i++){
-				if(regular_thread0[i] == nullptr){
-					continue;
-				}
-				regular_thread0[i]->join();
-			}
-			for(int i=0; i < regular_thread1.size(); i++){
-				if(regular_thread1[i] == nullptr){
-					continue;
-				}
-				regular_thread1[i]->join();
-			}
-		}
-		else{
-			for(int i=0; i < numa_thread0.size(); i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < numa_thread1.size(); i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
-
+		timed_init([&]{ numa_Stack_init(DS_config, num_DS/2, prefill_set, percentages); });
+		start_reporter(interval);
+		run_node_test(StackTest, duration, num_DS, num_threads, crossover);
+
+		stop_reporter();
+		print_time_series();
+		print_latency(duration);
+		print_locality(duration);
+		print_init_time(duration);
 		std::cout << ops0 << ", ";
 		std::cout << ops1 << ", ";
 		std::cout << ops0 + ops1 << "\n";
 	}
 
 	else if(DS_name == "queue"){
-		numa_Queue_init(DS_config, num_DS/2, prefill_set, percentages);
-		for(int i=0; i < num_threads/2; i++){
-			int node = 0;
-			int tid = i;
-			if(thread_config == "numa"){
-				numa_thread0[i] = new thread_numa<0>(QueueTest,tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else if(thread_config == "regular"){
-				regular_thread0[i] = new thread(QueueTest,tid, duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else{
-				numa_thread0[i] = new thread_numa<0>(QueueTest, tid, duration, i%2, num_DS/2, num_threads/2, crossover);
-			}
-		}
-		for(int i=0; i < num_threads/2; i++){
-			int node = 1;
-			int tid = i + num_threads/2;
-			if(thread_config == "numa"){
-				numa_thread1[i] = new thread_numa<1>(QueueTest,tid , duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else if(thread_config == "regular"){
-				regular_thread1[i] = new thread(QueueTest,tid , duration, node, num_DS/2, num_threads/2, crossover);
-			}
-			else{
-				numa_thread1[i] = new thread_numa<1>(QueueTest, tid, duration, i%2, num_DS/2, num_threads/2, crossover);
-			}
-		}
+		timed_init([&]{ numa_Queue_init(DS_config, num_DS/2, prefill_set, percentages); });
+		start_reporter(interval);
+		run_node_test(QueueTest, duration, num_DS, num_threads, crossover);
+
+		stop_reporter();
+		print_time_series();
+		print_latency(duration);
+		print_locality(duration);
+		print_init_time(duration);
+		std::cout << ops0 <<", ";
+		std::cout << ops1 << ", ";
+		std::cout <<ops0 + ops1 << "";
+	}
 
-		if(thread_config == "numa"){
-			
-			for(int i=0; i < numa_thread0.size(); i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < numa_thread1.size(); i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
 
-		else if(thread_config == "regular"){
-			for(int i=0; i < regular_thread0.size(); i++){
-				if(regular_thread0[i] == nullptr){
-					continue;
-				}
-				regular_thread0[i]->join();
-			}
-			for(int i=0; i < regular_thread1.size(); i++){
-				if(regular_thread1[i] == nullptr){
-					continue;
-				}
-				regular_thread1[i]->join();
-			}
-		}
-		else{
-			for(int i=0; i < numa_thread0.size(); i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < numa_thread1.size(); i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
 
-		std::cout << ops0 <<", ";
+	else if(DS_name == "lfstack"){
+		timed_init([&]{ numa_LFStack_init(DS_config, num_DS/2, prefill_set, percentages); });
+		start_reporter(interval);
+		run_node_test(LFStackTest, duration, num_DS, num_threads, crossover);
+
+		stop_reporter();
+		print_time_series();
+		print_latency(duration);
+		print_locality(duration);
+		print_init_time(duration);
+		std::cout << ops0 << ", ";
 		std::cout << ops1 << ", ";
-		std::cout <<ops0 + ops1 << "";
+		std::cout << ops0 + ops1 << "\n";
 	}
 
+	else if(DS_name == "lfqueue"){
+		timed_init([&]{ numa_LFQueue_init(DS_config, num_DS/2, prefill_set, percentages); });
+		start_reporter(interval);
+		run_node_test(LFQueueTest, duration, num_DS, num_threads, crossover);
 
+		stop_reporter();
+		print_time_series();
+		print_latency(duration);
+		print_locality(duration);
+		print_init_time(duration);
+		std::cout << ops0 << ", ";
+		std::cout << ops1 << ", ";
+		std::cout << ops0 + ops1 << "\n";
+	}
 
-	else if(DS_name == "bst"){
+	else if(DS_name == "bst" || DS_name == "btree" || DS_name == "avl"){
 		for(int i=0; i < run_freq; i++){
 			main_BST_test(duration, num_DS, num_threads, crossover, keyspace);
 		}
@@ -596,7 +607,7 @@ int main(int argc, char *argv[])
 
 
 
-		int newDuration = interval;
+
 		// //std::cout<< "Ops0 per 20 seconds: ";
 		// for(int i :globalOps0){
 		// 	print_function(newDuration, i, 0, 0);
@@ -608,10 +619,9 @@ int main(int argc, char *argv[])
 		
 		// }
 
-		for(int i = 0; i< globalOps0.size(); i++){
-			print_function(newDuration, globalOps0[i], globalOps1[i], globalOps0[i] + globalOps1[i]);
-			newDuration += interval;
-		}
+		print_time_series();
+		print_latency(duration);
+		print_init_time(duration);
 		// std::cout<<std::endl;
 		// std::cout<<"Total Ops seconds: ";
 		// std::cout << ops0 << ", ";
@@ -623,79 +633,15 @@ int main(int argc, char *argv[])
 
 
 	else if(DS_name == "ll"){
-		numa_LL_init(DS_config, num_DS/2, prefill_set, percentages);
-		for(int i=0; i < num_threads/2; i++){
-			int node = 0;
-			int tid = i;
-			if(thread_config == "numa"){
-				numa_thread0[i] = new thread_numa<0>(LinkedListTest,tid, duration, node, num_DS/2, num_threads, crossover);
-			}
-			else if(thread_config == "regular"){
-				regular_thread0[i] = new thread(LinkedListTest,tid, duration, node, num_DS/2, num_threads, crossover);
-			}
-			else{
-				numa_thread0[i] = new thread_numa<0>(LinkedListTest, tid, duration, i%2, num_DS/2, num_threads, crossover);
-			}
-		}
-		for(int i=0; i < num_threads/2; i++){
-			int node = 1;
-			int tid = i + num_threads/2;
-			if(thread_config == "numa"){
-				numa_thread1[i] = new thread_numa<1>(LinkedListTest,tid, duration, node, num_DS/2, num_threads, crossover);
-			}
-			else if(thread_config == "regular"){
-				regular_thread1[i] = new thread(LinkedListTest,tid, duration, node, num_DS/2, num_threads, crossover);
-			}
-			else{
-				numa_thread1[i] = new thread_numa<1>(LinkedListTest, tid, duration, i%2, num_DS/2, num_threads, crossover);
-			}
-		}
-
-		if(thread_config == "numa"){
-			for(int i=0; i < numa_thread0.size(); i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < numa_thread1.size(); i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
-
-
-		else if(thread_config == "regular"){
-			for(int i=0; i < regular_thread0.size(); i++){
-				if(regular_thread0[i] == nullptr){
-					continue;
-				}
-				regular_thread0[i]->join();
-			}
-			for(int i=0; i < regular_thread1.size(); i++){
-				if(regular_thread1[i] == nullptr){
-					continue;
-				}
-				regular_thread1[i]->join();
-			}
-		}
-		else{
-			for(int i=0; i < numa_thread0.size(); i++){
-				if(numa_thread0[i] == nullptr){
-					continue;
-				}
-				numa_thread0[i]->join();
-			}
-			for(int i=0; i < numa_thread1.size(); i++){
-				if(numa_thread1[i] == nullptr){
-					continue;
-				}
-				numa_thread1[i]->join();
-			}
-		}
-
+		timed_init([&]{ numa_LL_init(DS_config, num_DS/2, prefill_set, percentages); });
+		start_reporter(interval);
+		run_node_test(LinkedListTest, duration, num_DS, num_threads, crossover);
+
+		stop_reporter();
+		print_time_series();
+		print_latency(duration);
+		print_locality(duration);
+		print_init_time(duration);
 		std::cout <<  ops0 << ", ";
 		std::cout <<  ops1 << ", ";
 		std::cout << ops0 + ops1 << "";
@@ -704,6 +650,7 @@ int main(int argc, char *argv[])
 	else{
 		cout<<"Invalid Data Structure"<<endl;
 	}
+	delete workers;
 	global_cleanup();
 	// cout<<endl;
 }
@@ -0,0 +1,131 @@
+/*! \file slab_bench.cpp
+ * \brief Push/pop throughput of numa<Node,0> stacks and queues.
+ *
+ * Built twice by the Makefile: bin/slab_bench uses the default slab arena
+ * behind NumaAllocator, bin/slab_bench_direct is compiled with
+ * -DNUMA_ALLOC_DIRECT so every node is its own numa_alloc_onnode mapping.
+ *
+ * Usage: slab_bench <stack|queue> [num_threads] [duration]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <atomic>
+
+#include "numatype.hpp"
+#include "numathreads.hpp"
+#include "Node.hpp"
+
+using namespace std;
+
+#ifdef NUMA_ALLOC_DIRECT
+const char* alloc_name = "direct";
+#else
+const char* alloc_name = "slab";
+#endif
+
+int duration = 10;
+std::atomic<int64_t> totalOps(0);
+
+void stack_test(int tid){
+    std::mt19937 gen(tid);
+    std::uniform_int_distribution<> opDist(0, 1);
+    Node* top = nullptr;
+    int64_t ops = 0;
+    auto endTimer = std::chrono::steady_clock::now() + std::chrono::seconds(duration);
+    while (std::chrono::steady_clock::now() < endTimer) {
+        if(opDist(gen) == 0 || top == nullptr){
+            Node* n = new numa<Node,0>(tid, top);
+            top = n;
+        }
+        else{
+            numa<Node,0>* n = static_cast<numa<Node,0>*>(top);
+            top = top->getLink();
+            delete n;
+        }
+        ops++;
+    }
+    while(top != nullptr){
+        numa<Node,0>* n = static_cast<numa<Node,0>*>(top);
+        top = top->getLink();
+        delete n;
+    }
+    totalOps += ops;
+}
+
+void queue_test(int tid){
+    std::mt19937 gen(tid);
+    std::uniform_int_distribution<> opDist(0, 1);
+    Node* front = nullptr;
+    Node* rear = nullptr;
+    int64_t ops = 0;
+    auto endTimer = std::chrono::steady_clock::now() + std::chrono::seconds(duration);
+    while (std::chrono::steady_clock::now() < endTimer) {
+        if(opDist(gen) == 0 || front == nullptr){
+            Node* n = new numa<Node,0>(tid, nullptr);
+            if(rear == nullptr){
+                front = n;
+            }
+            else{
+                rear->setLink(n);
+            }
+            rear = n;
+        }
+        else{
+            numa<Node,0>* n = static_cast<numa<Node,0>*>(front);
+            front = front->getLink();
+            if(front == nullptr){
+                rear = nullptr;
+            }
+            delete n;
+        }
+        ops++;
+    }
+    while(front != nullptr){
+        numa<Node,0>* n = static_cast<numa<Node,0>*>(front);
+        front = front->getLink();
+        delete n;
+    }
+    totalOps += ops;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <stack|queue> [num_threads] [duration]\n";
+        return 1;
+    }
+
+    std::string DS_name = argv[1];
+    int num_threads = (argc > 2) ? std::stoi(argv[2]) : 1;
+    if (argc > 3) {
+        duration = std::stoi(argv[3]);
+    }
+
+    void (*test)(int);
+    if (DS_name == "stack") {
+        test = stack_test;
+    } else if (DS_name == "queue") {
+        test = queue_test;
+    } else {
+        std::cout << "Unknown option: " << DS_name << "\n";
+        return 1;
+    }
+
+    std::vector<thread_numa<0>*> threads(num_threads);
+    for(int i = 0; i < num_threads; i++){
+        threads[i] = new thread_numa<0>(test, i);
+    }
+    for(int i = 0; i < num_threads; i++){
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    // DS, allocator, num_threads, duration, total_ops, ops_per_sec
+    std::cout << DS_name << ", " << alloc_name << ", " << num_threads << ", " << duration << ", "
+              << totalOps << ", " << totalOps / duration << "\n";
+}
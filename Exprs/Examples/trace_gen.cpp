@@ -0,0 +1,118 @@
+/*! \file trace_gen.cpp
+ * \brief Writes an operation trace for DSExample --trace (format in OpTrace.hpp).
+ *
+ * Draws the same decisions the test loops make on the fly: for "pool"
+ * traces (stack, queue, ll, lfstack, lfqueue) an insert/remove on a
+ * structure, sent to the other pool half with probability crossover%; for
+ * "bst" traces (bst, btree, avl) 80% lookups on the thread's own half and
+ * 20% remove/insert transactions between two trees. Structure indices and
+ * keys follow ds_dist / key_dist (KeyDistribution.hpp specs).
+ *
+ * Section t is written for harness thread t. DSExample -t T puts threads
+ * 0..T/2-1 on node index 0 and the rest on 1, so that is the "own half" a
+ * section's lookups and non-crossover ops target. num_DS is the harness's
+ * -n: each half has num_DS/2 structures.
+ *
+ * Usage: trace_gen <out_file> <pool|bst> [threads] [num_DS] [ops_per_thread]
+ *                  [crossover] [keyspace] [ds_dist] [key_dist] [seed]
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "OpTrace.hpp"
+#include "KeyDistribution.hpp"
+#include "FastRandom.hpp"
+
+using namespace std;
+
+int main (int argc, char *argv[])
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <out_file> <pool|bst> [threads] [num_DS] [ops_per_thread]"
+                  << " [crossover] [keyspace] [ds_dist] [key_dist] [seed]\n";
+        return 1;
+    }
+
+    std::string path = argv[1];
+    std::string kind = argv[2];
+    int threads = (argc > 3) ? std::stoi(argv[3]) : 2;
+    int num_DS = (argc > 4) ? std::stoi(argv[4]) : 1000;
+    int64_t ops = (argc > 5) ? std::stoll(argv[5]) : (1 << 20);
+    int crossover = (argc > 6) ? std::stoi(argv[6]) : 0;
+    int keyspace = (argc > 7) ? std::stoi(argv[7]) : 80000;
+    std::string ds_dist = (argc > 8) ? argv[8] : "uniform";
+    std::string key_dist = (argc > 9) ? argv[9] : "uniform";
+    uint64_t seed = (argc > 10) ? std::stoull(argv[10]) : 123;
+
+    if (kind != "pool" && kind != "bst") {
+        std::cout << "Unknown option: " << kind << "\n";
+        return 1;
+    }
+    if (threads < 1 || num_DS < 2 || ops < 1) {
+        std::cerr << "threads, num_DS/2 and ops_per_thread must be positive\n";
+        return 1;
+    }
+    if (!KeyDistribution::known(ds_dist) || !KeyDistribution::known(key_dist)) {
+        std::cerr << "Unknown distribution: " << ds_dist << " / " << key_dist << "\n";
+        return 1;
+    }
+
+    int per_node = num_DS / 2;
+    std::vector<op_record> records;
+    records.reserve(size_t(threads) * ops);
+
+    for (int t = 0; t < threads; t++) {
+        uint8_t home = (t < (threads + 1) / 2) ? 0 : 1;
+        xoshiro256pp gen(seed + t);
+        KeyDistribution dsDist(ds_dist, 0, per_node - 1);
+        KeyDistribution keyDist(key_dist, 0, keyspace);
+        IntRange percent(1, 100);
+
+        for (int64_t i = 0; i < ops; ) {
+            op_record r;
+            std::memset(&r, 0, sizeof(r));
+            r.ds = dsDist(gen);
+            if (kind == "pool") {
+                r.op = random_range(gen, 0, 1);
+                r.node = (percent(gen) < crossover) ? 1 - home : home;
+                r.key = r.ds;
+            }
+            else {
+                r.key = keyDist(gen);
+                r.node = home;
+                if (percent(gen) > 80) {
+                    r.ds2 = dsDist(gen);
+                    int txn = percent(gen) % 4;
+                    // the loop skips same-tree transactions within one half
+                    if (txn >= 2 && r.ds == r.ds2) {
+                        continue;
+                    }
+                    r.op = 1 + txn;
+                }
+            }
+            records.push_back(r);
+            i++;
+        }
+    }
+
+    op_trace_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, OP_TRACE_MAGIC, sizeof(OP_TRACE_MAGIC));
+    header.kind = (kind == "pool") ? OP_TRACE_POOL : OP_TRACE_BST;
+    header.sections = threads;
+    header.ds_per_node = per_node;
+    header.keyspace = keyspace;
+    header.ops_per_section = ops;
+
+    if (!write_op_trace(path, header, records)) {
+        std::cerr << "Could not write " << path << "\n";
+        return 1;
+    }
+
+    // kind, threads, ds_per_node, ops_per_thread, bytes
+    std::cout << kind << ", " << threads << ", " << per_node << ", " << ops << ", "
+              << sizeof(header) + records.size() * sizeof(op_record) << "\n";
+}
@@ -0,0 +1,442 @@
+#ifndef _AVLTREE_HPP_
+#define _AVLTREE_HPP_
+
+
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include "BinaryNode.hpp"
+#include "EpochReclamation.hpp"
+using namespace std;
+
+/*!
+ * \class AVLTree
+ *
+ * \brief Height-balanced binary search tree of ints.
+ *
+ * A drop-in alternative to \class BinarySearchTree for the transaction
+ * benchmark (--DS_name=avl): same insert/lookup/optimisticLookup/remove
+ * interface and the same locking contract (one writer at a time, held by
+ * the caller). Sibling subtrees differ in height by at most one, so
+ * monotonic keys (--key_dist=sequential) give a tree of ~1.44 log2(n)
+ * levels instead of a list.
+ *
+ * The tree is built from plain \class BinaryNode objects and every
+ * rotation only relinks nodes reachable from this tree's root, so inside a
+ * numa<AVLTree,N> specialization the tool rewrites them to
+ * numa<BinaryNode,N> like it does for BinarySearchTree.
+ *
+ * Insert and remove record the path from the root in a fixed array and
+ * rebalance on the way back up, stopping at the first subtree whose height
+ * did not change; nothing recurses.
+ */
+
+class AVLTree
+{
+private:
+	static const int MAX_HEIGHT = 64;   //< > 1.44 * log2 of any int-sized tree
+
+	BinaryNode *root;   //< stored and read through std::atomic_ref where optimisticLookup() can race
+
+	//< Seqlock counter: odd while insert/remove is changing links.
+	//< Writers are still serialized by the caller's lock; the counter only
+	//< lets optimisticLookup() detect that it raced with one.
+	std::atomic<unsigned> version;
+
+	void beginWrite();
+	void endWrite();
+
+	static int heightOf(BinaryNode *node);
+	static void updateHeight(BinaryNode *node);
+
+	/*!
+	 * \brief Rotate node's right child up; returns the new subtree root.
+	 *
+	 * The child's inner subtree is handed to node before node is hung
+	 * below the child, so a racing optimistic reader never sees a cycle.
+	 */
+	static BinaryNode* rotateLeft(BinaryNode *node);
+
+	/*!
+	 * \brief Mirror of rotateLeft().
+	 */
+	static BinaryNode* rotateRight(BinaryNode *node);
+
+	/*!
+	 * \brief Restore the AVL condition at node, whose children are balanced.
+	 *
+	 * \return The root of the subtree, node itself if no rotation was needed.
+	 */
+	static BinaryNode* balance(BinaryNode *node);
+
+	/*!
+	 * \brief Point whichever link of parent held child (root if parent is NULL) at replacement.
+	 */
+	void replaceChild(BinaryNode *parent, BinaryNode *child, BinaryNode *replacement);
+
+	/*!
+	 * \brief Recompute heights and rotate from path[depth-1] up to the root.
+	 */
+	void rebalance(BinaryNode **path, int depth);
+
+public:
+	/*!
+	 * \brief AVLTree Constructor
+	 *
+	 */
+	AVLTree();
+
+	/*!
+	 * \brief AVLTree Destructor
+	 *
+	 * Frees every node.
+	 */
+	~AVLTree();
+
+	/*!
+	 * \brief Insert data into the tree
+	 *
+	 * \param[in] data Data to be inserted.
+	 * \return Level the data was inserted (or found) at.
+	 */
+	int insert(int data);
+
+	/*!
+	 * \brief Look up data in the tree
+	 *
+	 * \return Level data was found at, or the depth searched if it is absent.
+	 */
+	int lookup(int data);
+
+	/*!
+	 * \brief Look up data without holding the tree's lock
+	 *
+	 * Reads the tree optimistically and validates the walk against the
+	 * version counter, retrying if an insert or remove ran concurrently.
+	 * Removed nodes are retired through \class EpochReclamation, so a
+	 * reader that is still walking them never touches freed memory.
+	 *
+	 * \return Same as lookup().
+	 */
+	int optimisticLookup(int data);
+
+	/*!
+	 * \brief Remove data from the tree if present
+	 *
+	 * A node with two children is replaced by its in-order successor,
+	 * which is unlinked from its old place first and then takes over both
+	 * children.
+	 */
+	void remove(int data);
+
+	/*!
+	 * \brief Number of levels, 0 for an empty tree.
+	 */
+	int getDepth();
+
+	/*!
+	 * \brief Number of nodes in the tree.
+	 */
+	int getSize();
+
+};
+
+AVLTree::AVLTree() : root(NULL), version(0)
+{
+
+}
+
+AVLTree::~AVLTree()
+{
+	std::vector<BinaryNode*> pending;
+	if(root != NULL)
+	{
+		pending.push_back(root);
+	}
+	while(!pending.empty())
+	{
+		BinaryNode *node = pending.back();
+		pending.pop_back();
+		if(node->getLeftChild() != NULL)
+		{
+			pending.push_back(node->getLeftChild());
+		}
+		if(node->getRightChild() != NULL)
+		{
+			pending.push_back(node->getRightChild());
+		}
+		delete node;
+	}
+	root = NULL;
+}
+
+void AVLTree::beginWrite()
+{
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void AVLTree::endWrite()
+{
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+int AVLTree::heightOf(BinaryNode *node)
+{
+	return (node == NULL) ? 0 : node->getHeight();
+}
+
+void AVLTree::updateHeight(BinaryNode *node)
+{
+	int left = heightOf(node->getLeftChild());
+	int right = heightOf(node->getRightChild());
+	node->setHeight(((left > right) ? left : right) + 1);
+}
+
+BinaryNode* AVLTree::rotateLeft(BinaryNode *node)
+{
+	BinaryNode *child = node->getRightChild();
+	node->setRightChild(child->getLeftChild());
+	child->setLeftChild(node);
+	updateHeight(node);
+	updateHeight(child);
+	return child;
+}
+
+BinaryNode* AVLTree::rotateRight(BinaryNode *node)
+{
+	BinaryNode *child = node->getLeftChild();
+	node->setLeftChild(child->getRightChild());
+	child->setRightChild(node);
+	updateHeight(node);
+	updateHeight(child);
+	return child;
+}
+
+BinaryNode* AVLTree::balance(BinaryNode *node)
+{
+	int skew = heightOf(node->getLeftChild()) - heightOf(node->getRightChild());
+	if(skew > 1)
+	{
+		BinaryNode *left = node->getLeftChild();
+		if(heightOf(left->getLeftChild()) < heightOf(left->getRightChild()))
+		{
+			node->setLeftChild(rotateLeft(left));
+		}
+		return rotateRight(node);
+	}
+	if(skew < -1)
+	{
+		BinaryNode *right = node->getRightChild();
+		if(heightOf(right->getRightChild()) < heightOf(right->getLeftChild()))
+		{
+			node->setRightChild(rotateRight(right));
+		}
+		return rotateLeft(node);
+	}
+	return node;
+}
+
+void AVLTree::replaceChild(BinaryNode *parent, BinaryNode *child, BinaryNode *replacement)
+{
+	if(parent == NULL)
+	{
+		std::atomic_ref<BinaryNode*>(root).store(replacement, std::memory_order_release);
+	}
+	else if(parent->getLeftChild() == child)
+	{
+		parent->setLeftChild(replacement);
+	}
+	else
+	{
+		parent->setRightChild(replacement);
+	}
+}
+
+void AVLTree::rebalance(BinaryNode **path, int depth)
+{
+	for(int i = depth - 1; i >= 0; i--)
+	{
+		BinaryNode *node = path[i];
+		int before = node->getHeight();
+		updateHeight(node);
+		BinaryNode *top = balance(node);
+		if(top != node)
+		{
+			replaceChild((i > 0) ? path[i - 1] : NULL, node, top);
+		}
+		if(top->getHeight() == before)
+		{
+			// nothing above this subtree can have changed
+			break;
+		}
+	}
+}
+
+int AVLTree::insert(int data)
+{
+	BinaryNode *path[MAX_HEIGHT];
+	int depth = 0;
+	BinaryNode *current = root;
+	while(current != NULL)
+	{
+		if(data == current->getData())
+		{
+			return depth;
+		}
+		path[depth++] = current;
+		current = (data < current->getData()) ? current->getLeftChild() : current->getRightChild();
+	}
+
+	BinaryNode *leaf = new BinaryNode(data);
+	beginWrite();
+	if(depth == 0)
+	{
+		std::atomic_ref<BinaryNode*>(root).store(leaf, std::memory_order_release);
+	}
+	else if(data < path[depth - 1]->getData())
+	{
+		path[depth - 1]->setLeftChild(leaf);
+	}
+	else
+	{
+		path[depth - 1]->setRightChild(leaf);
+	}
+	rebalance(path, depth);
+	endWrite();
+	return depth;
+}
+
+int AVLTree::lookup(int data)
+{
+	BinaryNode *current = root;
+	int level = 0;
+	while(current != NULL)
+	{
+		if(current->getData() == data)
+		{
+			return level;
+		}
+		current = (data < current->getData()) ? current->getLeftChild() : current->getRightChild();
+		level++;
+	}
+	return level;
+}
+
+int AVLTree::optimisticLookup(int data)
+{
+	EpochReclamation::enter();
+	while(true)
+	{
+		unsigned v = version.load(std::memory_order_acquire);
+		if(v & 1)
+		{
+			// writer in progress
+			__builtin_ia32_pause();
+			continue;
+		}
+
+		BinaryNode *current = std::atomic_ref<BinaryNode*>(root).load(std::memory_order_acquire);
+		int level = 0;
+		// a walk longer than any valid tree raced with rotations; the
+		// version check below throws it away
+		while(current != NULL && level < MAX_HEIGHT)
+		{
+			int key = current->getData();
+			if(key == data)
+			{
+				break;
+			}
+			current = (data < key) ? current->getLeftChild() : current->getRightChild();
+			level++;
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(version.load(std::memory_order_relaxed) == v)
+		{
+			EpochReclamation::leave();
+			return level;
+		}
+	}
+}
+
+void AVLTree::remove(int data)
+{
+	BinaryNode *path[MAX_HEIGHT];
+	int depth = 0;
+	BinaryNode *current = root;
+	while(current != NULL && current->getData() != data)
+	{
+		path[depth++] = current;
+		current = (data < current->getData()) ? current->getLeftChild() : current->getRightChild();
+	}
+	if(current == NULL)
+	{
+		return;
+	}
+
+	BinaryNode *parent = (depth > 0) ? path[depth - 1] : NULL;
+	beginWrite();
+	if(current->getLeftChild() == NULL || current->getRightChild() == NULL)
+	{
+		BinaryNode *child = (current->getLeftChild() != NULL) ? current->getLeftChild() : current->getRightChild();
+		replaceChild(parent, current, child);
+	}
+	else
+	{
+		// the successor takes current's slot on the path
+		int slot = depth++;
+		BinaryNode *succParent = current;
+		BinaryNode *succ = current->getRightChild();
+		while(succ->getLeftChild() != NULL)
+		{
+			path[depth++] = succ;
+			succParent = succ;
+			succ = succ->getLeftChild();
+		}
+		if(succParent != current)
+		{
+			succParent->setLeftChild(succ->getRightChild());
+			succ->setRightChild(current->getRightChild());
+		}
+		succ->setLeftChild(current->getLeftChild());
+		succ->setHeight(current->getHeight());
+		replaceChild(parent, current, succ);
+		path[slot] = succ;
+	}
+	rebalance(path, depth);
+	endWrite();
+	EpochReclamation::retire(current);
+}
+
+int AVLTree::getDepth()
+{
+	return heightOf(root);
+}
+
+int AVLTree::getSize()
+{
+	int size = 0;
+	std::vector<BinaryNode*> pending;
+	if(root != NULL)
+	{
+		pending.push_back(root);
+	}
+	while(!pending.empty())
+	{
+		BinaryNode *node = pending.back();
+		pending.pop_back();
+		size++;
+		if(node->getLeftChild() != NULL)
+		{
+			pending.push_back(node->getLeftChild());
+		}
+		if(node->getRightChild() != NULL)
+		{
+			pending.push_back(node->getRightChild());
+		}
+	}
+	return size;
+}
+
+#endif //_AVLTREE_HPP_
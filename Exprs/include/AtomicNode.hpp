@@ -0,0 +1,72 @@
+#ifndef _ATOMICNODE_HPP_
+#define _ATOMICNODE_HPP_
+
+#include <atomic>
+
+/*!
+ * \class AtomicNode
+ *
+ * \brief Node for the lock-free Stack and Queue.
+ *
+ * Same shape as \class Node, but the link is a std::atomic so it can be
+ * the target of a compare-and-swap. The data field is written once before
+ * the node is published and never changes afterwards.
+ */
+
+class AtomicNode
+{
+private:
+	int data;
+	std::atomic<AtomicNode*> link;
+
+public:
+	AtomicNode() : data(0), link(nullptr)
+	{}
+	AtomicNode(int initData);
+	AtomicNode(int, AtomicNode*);
+
+	AtomicNode *getLink();
+	void setLink(AtomicNode *n);
+	std::atomic<AtomicNode*>& linkRef();
+
+	int getData();
+
+	~AtomicNode();
+};
+
+
+AtomicNode::AtomicNode(int initData) : data(initData), link(nullptr)
+{
+}
+
+AtomicNode::AtomicNode(int initData, AtomicNode *node) : data(initData), link(node)
+{
+}
+
+AtomicNode* AtomicNode::getLink()
+{
+	return link.load(std::memory_order_acquire);
+}
+
+void AtomicNode::setLink(AtomicNode *n)
+{
+	link.store(n, std::memory_order_release);
+}
+
+std::atomic<AtomicNode*>& AtomicNode::linkRef()
+{
+	return link;
+}
+
+int AtomicNode::getData()
+{
+	return data;
+}
+
+AtomicNode::~AtomicNode()
+{
+}
+
+
+
+#endif //_ATOMICNODE_HPP_
@@ -0,0 +1,333 @@
+#ifndef _BPLUSTREE_HPP_
+#define _BPLUSTREE_HPP_
+
+
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include "BTreeNode.hpp"
+using namespace std;
+
+/*!
+ * \class BPlusTree
+ *
+ * \brief B+-tree of ints with cache-line sized nodes.
+ *
+ * A drop-in alternative to \class BinarySearchTree for the transaction
+ * benchmark (--DS_name=btree): same insert/lookup/optimisticLookup/remove
+ * interface and the same locking contract (one writer at a time, held by
+ * the caller). Each level of a lookup reads one line of packed keys and one
+ * child pointer, so a tree of the benchmark's size is 4-5 levels deep
+ * instead of ~20 dependent pointer loads.
+ *
+ * Removal takes the key out of its leaf but does not merge or rebalance;
+ * under the benchmark's balanced insert/remove mix the leaves refill.
+ * Nodes are therefore only freed by the destructor, which is also what
+ * lets optimisticLookup() run without a reclamation scheme.
+ */
+
+class BPlusTree
+{
+private:
+	BTreeNode *root;   //< stored and read through std::atomic_ref where optimisticLookup() can race
+
+	//< Seqlock counter: odd while insert/remove is changing a node.
+	//< Writers are still serialized by the caller's lock; the counter only
+	//< lets optimisticLookup() detect that it raced with one.
+	std::atomic<unsigned> version;
+
+	void beginWrite();
+	void endWrite();
+
+	/*!
+	 * \brief Split the full child idx of parent, which must not be full itself.
+	 */
+	void splitChild(BTreeNode *parent, int idx);
+
+	/*!
+	 * \brief Leaf data belongs in, without changing the tree; root must not be NULL.
+	 *
+	 * \param[out] level Number of levels descended.
+	 * \param[out] pos lowerBound() of data in the leaf.
+	 */
+	BTreeNode *findLeaf(int data, int &level, int &pos);
+
+public:
+	/*!
+	 * \brief BPlusTree Constructor
+	 *
+	 */
+	BPlusTree();
+
+	/*!
+	 * \brief BPlusTree Destructor
+	 *
+	 * Frees every node.
+	 */
+	~BPlusTree();
+
+	/*!
+	 * \brief Insert data into the tree
+	 *
+	 * The leaf is searched first and an existing key returns without a
+	 * write section, as in BinarySearchTree::insert. Otherwise full nodes
+	 * met on the way down are split before descending, so the insert never
+	 * has to walk back up.
+	 *
+	 * \param[in] data Data to be inserted.
+	 * \return Number of levels descended.
+	 */
+	int insert(int data);
+
+	/*!
+	 * \brief Look up data in the tree
+	 *
+	 * Descends to the leaf data belongs in and searches it, as remove does.
+	 *
+	 * \return Number of levels descended, one more if data is not in the
+	 *         tree (like BinarySearchTree::lookup stepping past the last node).
+	 */
+	int lookup(int data);
+
+	/*!
+	 * \brief Look up data without holding the tree's lock
+	 *
+	 * Reads the tree optimistically and validates the walk against the
+	 * version counter, retrying if an insert or remove ran concurrently.
+	 * May run concurrently with one writer holding the tree's lock.
+	 *
+	 * \return Same as lookup().
+	 */
+	int optimisticLookup(int data);
+
+	/*!
+	 * \brief Remove data from the tree if present
+	 */
+	void remove(int data);
+
+	/*!
+	 * \brief Number of levels, 0 for an empty tree.
+	 */
+	int getDepth();
+
+	/*!
+	 * \brief Number of keys, found by walking the leaf chain.
+	 */
+	int getSize();
+
+};
+
+BPlusTree::BPlusTree() : root(NULL), version(0)
+{
+
+}
+
+BPlusTree::~BPlusTree()
+{
+	if(root == NULL)
+	{
+		return;
+	}
+	std::vector<BTreeNode*> pending;
+	pending.push_back(root);
+	while(!pending.empty())
+	{
+		BTreeNode *node = pending.back();
+		pending.pop_back();
+		if(!node->isLeaf())
+		{
+			for(int i = 0; i <= node->getCount(); i++)
+			{
+				pending.push_back(node->getChild(i));
+			}
+		}
+		delete node;
+	}
+	root = NULL;
+}
+
+void BPlusTree::beginWrite()
+{
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void BPlusTree::endWrite()
+{
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void BPlusTree::splitChild(BTreeNode *parent, int idx)
+{
+	int separator;
+	BTreeNode *right = parent->getChild(idx)->split(separator);
+	parent->insertSeparator(idx, separator, right);
+}
+
+BTreeNode *BPlusTree::findLeaf(int data, int &level, int &pos)
+{
+	BTreeNode *current = root;
+	level = 0;
+	while(!current->isLeaf())
+	{
+		current = current->getChild(current->upperBound(data));
+		level++;
+	}
+	pos = current->lowerBound(data);
+	return current;
+}
+
+int BPlusTree::insert(int data)
+{
+	int level = 0;
+	int pos;
+	if(root != NULL)
+	{
+		BTreeNode *leaf = findLeaf(data, level, pos);
+		if(pos < leaf->getCount() && leaf->getKey(pos) == data)
+		{
+			// already present: readers never see the version move
+			return level;
+		}
+	}
+
+	beginWrite();
+	if(root == NULL)
+	{
+		std::atomic_ref<BTreeNode*>(root).store(new BTreeNode(true), std::memory_order_release);
+	}
+	if(root->isFull())
+	{
+		BTreeNode *newRoot = new BTreeNode(false);
+		newRoot->setChild(0, root);
+		splitChild(newRoot, 0);
+		std::atomic_ref<BTreeNode*>(root).store(newRoot, std::memory_order_release);
+	}
+
+	BTreeNode *current = root;
+	level = 0;
+	while(!current->isLeaf())
+	{
+		int idx = current->upperBound(data);
+		if(current->getChild(idx)->isFull())
+		{
+			splitChild(current, idx);
+			if(data >= current->getKey(idx))
+			{
+				idx++;
+			}
+		}
+		current = current->getChild(idx);
+		level++;
+	}
+
+	current->insertKey(current->lowerBound(data), data);
+	endWrite();
+	return level;
+}
+
+int BPlusTree::lookup(int data)
+{
+	if(root == NULL)
+	{
+		return 0;
+	}
+	int level;
+	int pos;
+	BTreeNode *leaf = findLeaf(data, level, pos);
+	bool found = pos < leaf->getCount() && leaf->getKey(pos) == data;
+	return found ? level : level + 1;
+}
+
+int BPlusTree::optimisticLookup(int data)
+{
+	while(true)
+	{
+		unsigned v = version.load(std::memory_order_acquire);
+		if(v & 1)
+		{
+			// writer in progress
+			__builtin_ia32_pause();
+			continue;
+		}
+
+		BTreeNode *current = std::atomic_ref<BTreeNode*>(root).load(std::memory_order_acquire);
+		int level = 0;
+		while(current != NULL && !current->isLeaf())
+		{
+			// a racing split can leave count and children briefly out of
+			// step; the walk is discarded by the version check below
+			current = current->getChild(current->optimisticUpperBound(data));
+			level++;
+		}
+		bool found = false;
+		if(current != NULL)
+		{
+			// the bound stays within the node's line whatever count says
+			int pos = current->optimisticLowerBound(data);
+			found = pos < current->getCount() && current->getKey(pos) == data;
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(version.load(std::memory_order_relaxed) == v)
+		{
+			return found ? level : level + 1;
+		}
+	}
+}
+
+void BPlusTree::remove(int data)
+{
+	if(root == NULL)
+	{
+		return;
+	}
+	int level;
+	int pos;
+	BTreeNode *leaf = findLeaf(data, level, pos);
+	if(pos < leaf->getCount() && leaf->getKey(pos) == data)
+	{
+		beginWrite();
+		leaf->removeKey(pos);
+		endWrite();
+	}
+}
+
+int BPlusTree::getDepth()
+{
+	if(root == NULL)
+	{
+		return 0;
+	}
+	// every leaf is at the same depth
+	BTreeNode *current = root;
+	int depth = 1;
+	while(!current->isLeaf())
+	{
+		current = current->getChild(0);
+		depth++;
+	}
+	return depth;
+}
+
+int BPlusTree::getSize()
+{
+	if(root == NULL)
+	{
+		return 0;
+	}
+	BTreeNode *current = root;
+	while(!current->isLeaf())
+	{
+		current = current->getChild(0);
+	}
+	int size = 0;
+	while(current != NULL)
+	{
+		size += current->getCount();
+		current = current->getNext();
+	}
+	return size;
+}
+
+#endif //_BPLUSTREE_HPP_
@@ -0,0 +1,221 @@
+#ifndef _BTREENODE_HPP_
+#define _BTREENODE_HPP_
+
+
+#include <cstddef>
+#include <climits>
+#include <atomic>
+#include "KeySearch.hpp"
+
+
+
+/*!
+ * \class BTreeNode
+ *
+ * \brief Node of \class BPlusTree.
+ *
+ * The keys of a node fill exactly one 64-byte cache line: SLOTS ints,
+ * sorted, with every unused slot (always including the last one) holding
+ * INT_MAX. Searching a node is therefore one key_search::count_less16()
+ * over that line (two AVX2 or four SSE2 compares), instead of a chain of
+ * dependent loads and branches.
+ *
+ * Inner nodes and leaves share the class so a whole node is one allocation
+ * of one type; inside a numa<BPlusTree,N> specialization the tool rewrites
+ * it to numa<BTreeNode,N> and keys and child pointers move together.
+ *
+ * In an inner node children[i] covers keys k with keys[i-1] <= k < keys[i].
+ * A leaf has no children and uses children[0] as the link to the next leaf.
+ *
+ * BPlusTree::optimisticLookup() reads nodes while a writer may be changing
+ * them, so keys, count and children are stored through std::atomic_ref
+ * (relaxed, release for links) and the optimistic* searches read them the
+ * same way. The SIMD lowerBound()/upperBound() read the line directly and
+ * are only for callers holding the tree's lock. leaf is set before a node
+ * is published and never changes.
+ */
+
+class BTreeNode
+{
+public:
+	static const int SLOTS = 16;            //< 16 ints = one cache line of keys, the width of key_search::count_less16
+	static const int MAX_KEYS = SLOTS - 1;  //< the last slot is always INT_MAX padding
+
+private:
+	alignas(64) int keys[SLOTS];
+	BTreeNode *children[SLOTS];
+	int count;
+	bool leaf;
+
+	// writer side; the writer's own reads of the fields stay plain
+	void setKey(int i, int key) { std::atomic_ref<int>(keys[i]).store(key, std::memory_order_relaxed); }
+	void setCount(int n) { std::atomic_ref<int>(count).store(n, std::memory_order_relaxed); }
+
+public:
+	BTreeNode(bool isLeaf) : count(0), leaf(isLeaf)
+	{
+		for(int i = 0; i < SLOTS; i++)
+		{
+			keys[i] = INT_MAX;
+			children[i] = NULL;
+		}
+	}
+
+	~BTreeNode()
+	{
+		for(int i = 0; i < SLOTS; i++)
+		{
+			children[i] = NULL;
+		}
+	}
+
+	bool isLeaf() { return leaf; }
+	bool isFull() { return getCount() == MAX_KEYS; }
+	int getCount() { return std::atomic_ref<int>(count).load(std::memory_order_relaxed); }
+	int getKey(int i) { return std::atomic_ref<int>(keys[i]).load(std::memory_order_relaxed); }
+
+	BTreeNode *getChild(int i) { return std::atomic_ref<BTreeNode*>(children[i]).load(std::memory_order_acquire); }
+	void setChild(int i, BTreeNode *node) { std::atomic_ref<BTreeNode*>(children[i]).store(node, std::memory_order_release); }
+
+	BTreeNode *getNext() { return getChild(0); }
+	void setNext(BTreeNode *node) { setChild(0, node); }
+
+	/*!
+	 * \brief Number of keys smaller than key (the slot key belongs in).
+	 */
+	int lowerBound(int key)
+	{
+		return key_search::count_less16(keys, key);
+	}
+
+	/*!
+	 * \brief Number of keys smaller than or equal to key (the child to descend into).
+	 */
+	int upperBound(int key)
+	{
+		int pos = key_search::count_less_equal16(keys, key);
+		// only reachable for key == INT_MAX, which also matches the padding
+		return pos < count ? pos : count;
+	}
+
+	/*!
+	 * \brief Lower bound from a snapshot of the line taken with relaxed loads, for optimistic readers.
+	 */
+	int optimisticLowerBound(int key)
+	{
+		alignas(64) int line[SLOTS];
+		for(int i = 0; i < SLOTS; i++)
+		{
+			line[i] = getKey(i);
+		}
+		return key_search::count_less16(line, key);
+	}
+
+	/*!
+	 * \brief upperBound() for optimistic readers; may be off while a writer races, never out of the node.
+	 */
+	int optimisticUpperBound(int key)
+	{
+		alignas(64) int line[SLOTS];
+		for(int i = 0; i < SLOTS; i++)
+		{
+			line[i] = getKey(i);
+		}
+		int pos = key_search::count_less_equal16(line, key);
+		int n = getCount();
+		return pos < n ? pos : n;
+	}
+
+	/*!
+	 * \brief Insert key at pos in a leaf, shifting the larger keys right.
+	 */
+	void insertKey(int pos, int key)
+	{
+		for(int i = count; i > pos; i--)
+		{
+			setKey(i, keys[i - 1]);
+		}
+		setKey(pos, key);
+		setCount(count + 1);
+	}
+
+	/*!
+	 * \brief Remove the key at pos from a leaf.
+	 */
+	void removeKey(int pos)
+	{
+		for(int i = pos; i < count - 1; i++)
+		{
+			setKey(i, keys[i + 1]);
+		}
+		setCount(count - 1);
+		setKey(count, INT_MAX);
+	}
+
+	/*!
+	 * \brief Insert separator key at pos of an inner node with right as the child after it.
+	 */
+	void insertSeparator(int pos, int key, BTreeNode *right)
+	{
+		for(int i = count; i > pos; i--)
+		{
+			setKey(i, keys[i - 1]);
+			setChild(i + 1, children[i]);
+		}
+		setKey(pos, key);
+		setChild(pos + 1, right);
+		setCount(count + 1);
+	}
+
+	/*!
+	 * \brief Split a full node in two.
+	 *
+	 * The upper half moves to a new node of the same kind. For a leaf the
+	 * separator is a copy of the new node's first key and the new leaf is
+	 * linked in after this one; for an inner node the middle key moves up
+	 * and is no longer stored in either half.
+	 *
+	 * \param[out] separator Key to insert into the parent in front of the new node.
+	 * \return The new right-hand node.
+	 */
+	BTreeNode *split(int &separator)
+	{
+		BTreeNode *right = new BTreeNode(leaf);
+		if(leaf)
+		{
+			int keep = (count + 1) / 2;
+			for(int i = keep; i < count; i++)
+			{
+				right->keys[i - keep] = keys[i];
+				setKey(i, INT_MAX);
+			}
+			right->count = count - keep;
+			setCount(keep);
+			separator = right->keys[0];
+			right->setNext(getNext());
+			setNext(right);
+		}
+		else
+		{
+			int mid = count / 2;
+			separator = keys[mid];
+			for(int i = mid + 1; i < count; i++)
+			{
+				right->keys[i - mid - 1] = keys[i];
+				setKey(i, INT_MAX);
+			}
+			for(int i = mid + 1; i <= count; i++)
+			{
+				right->children[i - mid - 1] = children[i];
+				setChild(i, NULL);
+			}
+			setKey(mid, INT_MAX);
+			right->count = count - mid - 1;
+			setCount(mid);
+		}
+		return right;
+	}
+
+};
+
+#endif /* _BTREENODE_HPP_ */
@@ -3,6 +3,7 @@
 
 
 #include <cstddef>
+#include <atomic>
 
 
 
@@ -15,6 +16,15 @@
  * node inherits from a Node object.  Members added to 
  * the BinaryNode are isRoot, leftChild, rightChild
  *
+ * height is only maintained by \class AVLTree; it sits in what would
+ * otherwise be padding after data, so the node stays 24 bytes.
+ *
+ * The trees' optimistic lookups read data and the child links while a
+ * writer may be storing to them, so those go through std::atomic_ref:
+ * relaxed for data, release/acquire for the links so that a reader that
+ * follows a link also sees the node's initialized fields. On x86 all of
+ * them are plain moves. height is only touched under the tree's lock.
+ *
  */
 
 class BinaryNode //: public Node
@@ -22,6 +32,7 @@ class BinaryNode //: public Node
 private:
 	//< Inherits int data from Node
 	int data;
+	int height;      //< levels in the subtree rooted here, 1 for a leaf
 	BinaryNode *leftChild;
 	BinaryNode *rightChild;
 
@@ -29,11 +40,11 @@ public:
 	//< Inherits int getData() from Node 
 
 
-	BinaryNode() : data(0), leftChild(NULL), rightChild(NULL)
+	BinaryNode() : data(0), height(1), leftChild(NULL), rightChild(NULL)
 	{}
 
 	BinaryNode(int data) 
-	: data(data), leftChild(NULL), rightChild(NULL)
+	: data(data), height(1), leftChild(NULL), rightChild(NULL)
 	{}
 
 	~BinaryNode()
@@ -43,14 +54,17 @@ public:
 		rightChild = NULL;
 	}
 
-	int getData() { return data; }
-	void setData(int data) { data = data; }
+	int getData() { return std::atomic_ref<int>(data).load(std::memory_order_relaxed); }
+	void setData(int data) { std::atomic_ref<int>(this->data).store(data, std::memory_order_relaxed); }
+
+	int getHeight() { return height; }
+	void setHeight(int height) { this->height = height; }
 
-	BinaryNode *getLeftChild() { return leftChild; }
-	BinaryNode *getRightChild() { return rightChild; }
+	BinaryNode *getLeftChild() { return std::atomic_ref<BinaryNode*>(leftChild).load(std::memory_order_acquire); }
+	BinaryNode *getRightChild() { return std::atomic_ref<BinaryNode*>(rightChild).load(std::memory_order_acquire); }
 
-	void setLeftChild(BinaryNode *node) { leftChild = node; }
-	void setRightChild(BinaryNode *node) { rightChild = node; }
+	void setLeftChild(BinaryNode *node) { std::atomic_ref<BinaryNode*>(leftChild).store(node, std::memory_order_release); }
+	void setRightChild(BinaryNode *node) { std::atomic_ref<BinaryNode*>(rightChild).store(node, std::memory_order_release); }
 
 
 
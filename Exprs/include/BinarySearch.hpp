@@ -6,7 +6,13 @@
 //#include "BinaryNode.hpp"
 
 #include <iostream>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <cstdint>
 #include "BinaryNode.hpp"
+#include "EpochReclamation.hpp"
 using namespace std;
 class BinaryNode;
 
@@ -23,8 +29,46 @@ class BinaryNode;
 class BinarySearchTree
 {
 private:
-	BinaryNode *root;
-	
+	BinaryNode *root;   //< stored and read through std::atomic_ref where optimisticLookup() can race
+
+	//< Seqlock counter: odd while insert/remove is changing links.
+	//< Writers are still serialized by the caller's lock; the counter only
+	//< lets optimisticLookup() detect that it raced with one.
+	std::atomic<unsigned> version;
+
+	//< Nodes linked into the tree, changed inside the writer's version
+	//< section. No valid walk is longer, so optimisticLookup() uses it to
+	//< stop a walk that went wrong through a node insert() just reused.
+	std::atomic<int> nodeCount;
+
+	void beginWrite();
+	void endWrite();
+
+	//< Nodes unlinked by remove(), oldest first, each with the epoch it was
+	//< unlinked in. insert() takes them back once no optimistic reader can
+	//< still be walking them, so the tree keeps reusing the nodes it already
+	//< placed instead of going back to the allocator.
+	std::deque<std::pair<BinaryNode*, uint64_t>> freeList;
+	uint64_t safeEpoch;   //< stamps below this are reusable, as of the last EpochReclamation::safe_epoch() (never above the epoch it bumped to)
+	int freesUntilScan;   //< remove()s left before insert() may ask for a newer safeEpoch
+
+	static const int FREE_LIST_SCAN = 32;     //< remove()s between two safe_epoch() scans
+	static const size_t FREE_LIST_MAX = 4096; //< past this, the oldest parked node goes to EpochReclamation
+
+	/*!
+	 * \brief A node holding data, from the free list if one is reusable.
+	 */
+	BinaryNode* allocNode(int data);
+
+	/*!
+	 * \brief Park a node that remove() has just unlinked.
+	 */
+	void freeNode(BinaryNode *node);
+
+	/*!
+	 * \brief Point whichever link of parent held child (root if parent is NULL) at replacement.
+	 */
+	void replaceChild(BinaryNode *parent, BinaryNode *child, BinaryNode *replacement);
 
 public:
 	/*!
@@ -37,27 +81,33 @@ public:
 	/*!
 	 * \brief BinarySearchTree Destructor
 	 *
+	 * Frees every node, including the ones parked on the free list.
 	 */
 	~BinarySearchTree();
 
+	BinaryNode* findMin(BinaryNode *node);
+
 	/*!
 	 * \brief Insert data into the binary search tree
-	 * 
-	 * This method allows us to insert data into the BST via
-	 * recursion.
-	 *
 	 *
 	 * \param[in] data Data to be inserted.
+	 * \return Level the data was inserted (or found) at.
 	 *
 	 */
-	BinaryNode* deleteHelper(BinaryNode* parent, BinaryNode *node, int data);
-
-	BinaryNode* findMin(BinaryNode *node);
-
 	int insert(int data);
 
+	/*!
+	 * \brief Number of levels, 0 for an empty tree.
+	 *
+	 * Walks the tree level by level, so a degenerate (list-shaped) tree
+	 * costs heap space for one level rather than stack for every node.
+	 */
 	int getDepth();
-	int getDepthHelper(BinaryNode *node);
+
+	/*!
+	 * \brief Number of nodes in the tree.
+	 */
+	int getSize();
 	/*!
 	 * \brief Look up data in the binary search tree
 	 * 
@@ -70,6 +120,19 @@ public:
 
 	int lookup(int data);
 
+	/*!
+	 * \brief Look up data without holding the tree's lock
+	 *
+	 * Reads the tree optimistically and validates the walk against the
+	 * version counter, retrying if an insert or remove ran concurrently.
+	 * Nodes unlinked by remove are retired through \class EpochReclamation,
+	 * so a reader that is still walking them never touches freed memory.
+	 * May run concurrently with one writer holding the tree's lock.
+	 *
+	 * \return Same as lookup().
+	 */
+	int optimisticLookup(int data);
+
 	/*!
 	 * 
 	 * \brief Post order print method to display the tree
@@ -117,18 +180,107 @@ public:
 
 	void update(int data);
 
+	/*!
+	 * \brief Remove data from the tree if present
+	 *
+	 * Walks down iteratively, keeping the parent. A node with two children
+	 * is replaced by its in-order successor, which is unlinked from its old
+	 * place first and then takes over both children, so no node is copied.
+	 * The removed node is parked on the tree's free list for insert().
+	 */
 	void remove(int data);
 
 };
 
-BinarySearchTree::BinarySearchTree() : root(NULL)
+BinarySearchTree::BinarySearchTree() : root(NULL), version(0), nodeCount(0), safeEpoch(0), freesUntilScan(FREE_LIST_SCAN)
 {
 	
 }
 
+void BinarySearchTree::beginWrite()
+{
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void BinarySearchTree::endWrite()
+{
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
 BinarySearchTree::~BinarySearchTree()
 {
+	std::vector<BinaryNode*> pending;
+	if(root != NULL)
+	{
+		pending.push_back(root);
+	}
+	while(!pending.empty())
+	{
+		BinaryNode *node = pending.back();
+		pending.pop_back();
+		if(node->getLeftChild() != NULL)
+		{
+			pending.push_back(node->getLeftChild());
+		}
+		if(node->getRightChild() != NULL)
+		{
+			pending.push_back(node->getRightChild());
+		}
+		delete node;
+	}
 	root = NULL;
+	for(auto& parked : freeList)
+	{
+		delete parked.first;
+	}
+	freeList.clear();
+}
+
+BinaryNode* BinarySearchTree::allocNode(int data)
+{
+	if(!freeList.empty() && freeList.front().second >= safeEpoch && freesUntilScan <= 0)
+	{
+		safeEpoch = EpochReclamation::safe_epoch();
+		freesUntilScan = FREE_LIST_SCAN;
+	}
+	if(!freeList.empty() && freeList.front().second < safeEpoch)
+	{
+		BinaryNode *node = freeList.front().first;
+		freeList.pop_front();
+		node->setData(data);
+		node->setLeftChild(NULL);
+		node->setRightChild(NULL);
+		return node;
+	}
+	return new BinaryNode(data);
+}
+
+void BinarySearchTree::freeNode(BinaryNode *node)
+{
+	if(freeList.size() >= FREE_LIST_MAX)
+	{
+		EpochReclamation::retire(freeList.front().first);
+		freeList.pop_front();
+	}
+	freeList.emplace_back(node, EpochReclamation::stamp());
+	freesUntilScan--;
+}
+
+void BinarySearchTree::replaceChild(BinaryNode *parent, BinaryNode *child, BinaryNode *replacement)
+{
+	if(parent == NULL)
+	{
+		std::atomic_ref<BinaryNode*>(root).store(replacement, std::memory_order_release);
+	}
+	else if(parent->getLeftChild() == child)
+	{
+		parent->setLeftChild(replacement);
+	}
+	else
+	{
+		parent->setRightChild(replacement);
+	}
 }
 
 void BinarySearchTree::update(int data)
@@ -157,73 +309,62 @@ void BinarySearchTree::update(int data)
 
 void BinarySearchTree::remove(int data)
 {
-	if(root==NULL){return;}
-	if(root->getData() == data)
+	BinaryNode *parent = NULL;
+	BinaryNode *current = root;
+	while(current != NULL && current->getData() != data)
+	{
+		parent = current;
+		current = (data < current->getData()) ? current->getLeftChild() : current->getRightChild();
+	}
+	if(current == NULL)
 	{
-		delete root;
-		root = NULL;
 		return;
 	}
-	else if (root->getData() < data) {
-        root->setLeftChild(deleteHelper(root, root->getLeftChild(), data));
-    } 
-	else if (data > root->getData()) {
-        root->setRightChild( deleteHelper(root, root->getRightChild(), data));
-    }
-
-
-	//root = deleteHelper(root, data);
-	// if(root == NULL)
-	// {
-	// 	return;
-	// }
-	// BinaryNode *current = root;
-	// BinaryNode *parent = NULL;
-	// bool isLeft = false;
-	// while(current != NULL)
-	// {
-	// 	if(current->getData() == data)
-	// 	{
-	// 		if(parent == NULL){
-	// 			delete current;
-	// 			root = NULL;
-	// 			return;
-	// 		}
-
-	// 		if(isLeft){
-	// 			BinaryNode *replacement = current->getRightChild();
-	// 			parent->setLeftChild(replacement);
-	// 			replacement->setLeftChild(current->getLeftChild());
-	// 			delete current;
-	// 		}
-	// 		else{
-	// 			BinaryNode *replacement = current->getLeftChild();
-	// 			parent->setRightChild(replacement);
-	// 			replacement->setRightChild(current->getRightChild());
-	// 			delete current;
-	// 		}
-	// 		return;
-	// 	}
-	// 	if(data < current->getData())
-	// 	{
-	// 		parent = current;
-	// 		current = current->getLeftChild();
-	// 		isLeft = true;
-	// 	}else
-	// 	{
-	// 		parent = current;
-	// 		current = current->getRightChild();
-	// 		isLeft = false;
-	// 	}
-	// }
+
+	beginWrite();
+	BinaryNode *replacement;
+	if(current->getLeftChild() == NULL)
+	{
+		replacement = current->getRightChild();
+	}
+	else if(current->getRightChild() == NULL)
+	{
+		replacement = current->getLeftChild();
+	}
+	else
+	{
+		BinaryNode *succParent = current;
+		BinaryNode *succ = current->getRightChild();
+		while(succ->getLeftChild() != NULL)
+		{
+			succParent = succ;
+			succ = succ->getLeftChild();
+		}
+		if(succParent != current)
+		{
+			// take succ out of its old place before it becomes an ancestor of
+			// that place, so a racing reader cannot walk into a cycle
+			succParent->setLeftChild(succ->getRightChild());
+			succ->setRightChild(current->getRightChild());
+		}
+		succ->setLeftChild(current->getLeftChild());
+		replacement = succ;
+	}
+	replaceChild(parent, current, replacement);
+	nodeCount.store(nodeCount.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+	endWrite();
+	freeNode(current);
 }
 
 int BinarySearchTree::insert(int data)
 {
-	BinaryNode *leaf = new BinaryNode(data);
 	if(root == NULL)
 	{
-		root = leaf;
+		BinaryNode *leaf = allocNode(data);
+		beginWrite();
+		std::atomic_ref<BinaryNode*>(root).store(leaf, std::memory_order_release);
+		nodeCount.store(1, std::memory_order_relaxed);
+		endWrite();
 		return 0;
 	}
 	BinaryNode *current = root;
@@ -245,18 +386,21 @@ int BinarySearchTree::insert(int data)
 		}
 		else{
 			//std::cout << data << " already exists at level " << level << std::endl;
-			delete leaf;
 			return level;
 		}
 	}
 
 	//current = leaf;
+	BinaryNode *leaf = allocNode(data);
+	beginWrite();
 	if(data < parent->getData()){
 		parent->setLeftChild(leaf);
 	}
 	else {
 		parent->setRightChild(leaf);
 	}
+	nodeCount.store(nodeCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	endWrite();
 	//std::cout << "Inserted " << data << " at level " << level << std::endl;
 	return level;
 }
@@ -264,19 +408,56 @@ int BinarySearchTree::insert(int data)
 
 int BinarySearchTree::getDepth()
 {
-	return getDepthHelper(root);
-	
+	int depth = 0;
+	std::vector<BinaryNode*> level;
+	std::vector<BinaryNode*> next;
+	if(root != NULL)
+	{
+		level.push_back(root);
+	}
+	while(!level.empty())
+	{
+		depth++;
+		next.clear();
+		for(BinaryNode *node : level)
+		{
+			if(node->getLeftChild() != NULL)
+			{
+				next.push_back(node->getLeftChild());
+			}
+			if(node->getRightChild() != NULL)
+			{
+				next.push_back(node->getRightChild());
+			}
+		}
+		level.swap(next);
+	}
+	return depth;
 }
 
-int BinarySearchTree::getDepthHelper(BinaryNode *node)
+int BinarySearchTree::getSize()
 {
-	if(node == NULL)
-		return 0;
-	
-	int leftDepth = getDepthHelper(node->getLeftChild());
-	int rightDepth = getDepthHelper(node->getRightChild());
-	return std::max(leftDepth, rightDepth) + 1;
-	
+	int size = 0;
+	std::vector<BinaryNode*> pending;
+	if(root != NULL)
+	{
+		pending.push_back(root);
+	}
+	while(!pending.empty())
+	{
+		BinaryNode *node = pending.back();
+		pending.pop_back();
+		size++;
+		if(node->getLeftChild() != NULL)
+		{
+			pending.push_back(node->getLeftChild());
+		}
+		if(node->getRightChild() != NULL)
+		{
+			pending.push_back(node->getRightChild());
+		}
+	}
+	return size;
 }
 
 int BinarySearchTree::lookup(int data)
@@ -310,6 +491,44 @@ int BinarySearchTree::lookup(int data)
 	return level;
 }
 
+int BinarySearchTree::optimisticLookup(int data)
+{
+	EpochReclamation::enter();
+	while (true)
+	{
+		unsigned v = version.load(std::memory_order_acquire);
+		if (v & 1)
+		{
+			// writer in progress
+			__builtin_ia32_pause();
+			continue;
+		}
+
+		BinaryNode *current = std::atomic_ref<BinaryNode*>(root).load(std::memory_order_acquire);
+		int level = 0;
+		// a walk longer than the tree has nodes went through a reused node;
+		// the version check below throws it away
+		int limit = nodeCount.load(std::memory_order_relaxed);
+		while (current != NULL && level <= limit)
+		{
+			int key = current->getData();
+			if (key == data)
+			{
+				break;
+			}
+			current = (data < key) ? current->getLeftChild() : current->getRightChild();
+			level++;
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (version.load(std::memory_order_relaxed) == v)
+		{
+			EpochReclamation::leave();
+			return level;
+		}
+	}
+}
+
 void BinarySearchTree::postOrderPrint()
 {
 	std::cout << "Post Order Print" << std::endl;
@@ -385,45 +604,4 @@ BinaryNode* BinarySearchTree::findMin(BinaryNode *node){
 }
 
 
-BinaryNode* BinarySearchTree::deleteHelper(BinaryNode* parent, BinaryNode *node, int key){
-	if (!node) return nullptr; // Key not found
-
-    if (key < node->getData()) {
-        node->setLeftChild(deleteHelper(node, node->getLeftChild(), key));
-    } 
-	else if (key > node->getData()) {
-        node->setRightChild( deleteHelper(node, node->getRightChild(), key));
-    } else {
-         // Node found, handle deletion cases
-        if (!node->getLeftChild()) {
-			BinaryNode* temp = node->getRightChild();
-			delete node;
-			return temp;
-        } 
-		else if (!node->getRightChild()) {
-			BinaryNode* temp = node->getLeftChild();
-			delete node;
-			return temp;
-        }
-
-            // Two children: Replace with inorder successor
-            BinaryNode* temp = findMin(node->getRightChild());
-			BinaryNode* temp2 = new BinaryNode(temp->getData());
-			temp2->setLeftChild(node->getLeftChild());
-			temp2->setRightChild(node->getRightChild());
-			delete node;
-			//node->setData(temp->getData());
-			if(parent->getData() > temp2->getData())
-			{
-				parent->setLeftChild(temp2);
-			}
-			else
-			{
-				parent->setRightChild(temp2);
-			}
-			node->setRightChild(deleteHelper(temp2, temp2->getRightChild(), temp2->getData()));
-        }
-        return node;
-}
-
 #endif //_BINARYSEARCH_HPP_
\ No newline at end of file
@@ -0,0 +1,237 @@
+/*! \file EpochReclamation.hpp
+ * \brief Epoch-based reclamation for optimistic readers
+ *
+ */
+
+#ifndef _EPOCHRECLAMATION_HPP_
+#define _EPOCHRECLAMATION_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+
+/*!
+ * \class EpochReclamation
+ *
+ * \brief Global epoch domain for readers that walk a structure without locks.
+ *
+ * A reader brackets its traversal with enter()/leave(), which publishes the
+ * global epoch it started in. Writers still unlink nodes under their own
+ * lock but hand them to retire() instead of deleting them; a retired node
+ * is stamped with the epoch current at unlink time and freed only once
+ * every reader that is still inside started in a later epoch, i.e. after
+ * the node became unreachable.
+ *
+ * Unlike \class HazardPointers this costs one store per traversal rather
+ * than one per node visited, which is what a tree walk needs.
+ */
+
+class EpochReclamation
+{
+public:
+	static const int MAX_THREADS = 512;     //< records in the domain
+	static const int SCAN_THRESHOLD = 256;  //< retired nodes before a thread scans
+
+	/*!
+	 * \brief Mark the calling thread as reading; nodes reachable from now on stay allocated.
+	 */
+	static void enter();
+
+	/*!
+	 * \brief End the read section started by enter().
+	 */
+	static void leave();
+
+	/*!
+	 * \brief Hand an unlinked node to the domain for deferred deletion.
+	 */
+	template<typename T>
+	static void retire(T* node);
+
+	/*!
+	 * \brief Epoch to stamp a node with when the caller recycles it itself instead of retiring it.
+	 *
+	 * Call after the node has been unlinked.
+	 */
+	static uint64_t stamp();
+
+	/*!
+	 * \brief Advance the epoch and return the oldest one a reader is still in.
+	 *
+	 * A node stamped with an epoch below the returned value is no longer
+	 * reachable by any reader and may be reused or freed. With no reader
+	 * inside, the result is the freshly bumped epoch, never QUIESCENT, so
+	 * a caller that caches it does not clear stamps handed out later.
+	 */
+	static uint64_t safe_epoch();
+
+private:
+	static const uint64_t QUIESCENT = UINT64_MAX;
+
+	struct alignas(64) Record
+	{
+		std::atomic<bool> active{false};
+		std::atomic<uint64_t> epoch{QUIESCENT};
+	};
+
+	struct Retired
+	{
+		void* ptr;
+		void (*deleter)(void*);
+		uint64_t epoch;
+	};
+
+	struct ThreadState
+	{
+		Record* rec = nullptr;
+		std::vector<Retired> retired;
+		~ThreadState();
+	};
+
+	alignas(64) static std::atomic<uint64_t> global_epoch;
+	static Record records[MAX_THREADS];
+	static std::mutex orphan_lk;
+	static std::vector<Retired> orphans;   //< retired by threads that exited before they could free them
+
+	static ThreadState& state();
+	static Record* acquire();
+	static void scan(std::vector<Retired>& retired);
+
+	template<typename T>
+	static void destroy(void* p)
+	{
+		delete static_cast<T*>(p);
+	}
+};
+
+
+alignas(64) inline std::atomic<uint64_t> EpochReclamation::global_epoch{0};
+inline EpochReclamation::Record EpochReclamation::records[EpochReclamation::MAX_THREADS];
+inline std::mutex EpochReclamation::orphan_lk;
+inline std::vector<EpochReclamation::Retired> EpochReclamation::orphans;
+
+
+inline EpochReclamation::ThreadState::~ThreadState()
+{
+	if(rec == nullptr)
+	{
+		return;
+	}
+	rec->epoch.store(QUIESCENT, std::memory_order_release);
+	scan(retired);
+	if(!retired.empty())
+	{
+		std::lock_guard<std::mutex> guard(orphan_lk);
+		orphans.insert(orphans.end(), retired.begin(), retired.end());
+	}
+	rec->active.store(false, std::memory_order_release);
+}
+
+inline EpochReclamation::ThreadState& EpochReclamation::state()
+{
+	thread_local ThreadState s;
+	if(s.rec == nullptr)
+	{
+		s.rec = acquire();
+	}
+	return s;
+}
+
+inline EpochReclamation::Record* EpochReclamation::acquire()
+{
+	for(int i = 0; i < MAX_THREADS; i++)
+	{
+		bool expected = false;
+		if(!records[i].active.load(std::memory_order_relaxed) &&
+		   records[i].active.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+		{
+			return &records[i];
+		}
+	}
+	std::cerr << "EpochReclamation: more than " << MAX_THREADS << " live threads" << std::endl;
+	std::abort();
+}
+
+inline void EpochReclamation::enter()
+{
+	Record* rec = state().rec;
+	rec->epoch.store(global_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	// The announcement must be visible before the first pointer is read:
+	// a scan that misses it is then ordered before the reader's traversal
+	// and only frees nodes the reader can no longer reach.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline void EpochReclamation::leave()
+{
+	state().rec->epoch.store(QUIESCENT, std::memory_order_release);
+}
+
+template<typename T>
+void EpochReclamation::retire(T* node)
+{
+	ThreadState& s = state();
+	s.retired.push_back(Retired{node, &destroy<T>, stamp()});
+	if(s.retired.size() >= SCAN_THRESHOLD)
+	{
+		scan(s.retired);
+	}
+}
+
+inline uint64_t EpochReclamation::stamp()
+{
+	return global_epoch.load(std::memory_order_seq_cst);
+}
+
+inline uint64_t EpochReclamation::safe_epoch()
+{
+	// Readers that enter from here on see the bumped epoch, which is newer
+	// than every stamp already handed out.
+	uint64_t oldest = global_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+	for(int i = 0; i < MAX_THREADS; i++)
+	{
+		uint64_t e = records[i].epoch.load(std::memory_order_seq_cst);
+		if(e < oldest)
+		{
+			oldest = e;
+		}
+	}
+	return oldest;
+}
+
+inline void EpochReclamation::scan(std::vector<Retired>& retired)
+{
+	{
+		// Pick up whatever exited threads left behind so it is not leaked.
+		std::unique_lock<std::mutex> guard(orphan_lk, std::try_to_lock);
+		if(guard.owns_lock() && !orphans.empty())
+		{
+			retired.insert(retired.end(), orphans.begin(), orphans.end());
+			orphans.clear();
+		}
+	}
+
+	uint64_t oldest = safe_epoch();
+
+	size_t kept = 0;
+	for(size_t i = 0; i < retired.size(); i++)
+	{
+		if(retired[i].epoch < oldest)
+		{
+			retired[i].deleter(retired[i].ptr);
+		}
+		else
+		{
+			retired[kept++] = retired[i];
+		}
+	}
+	retired.resize(kept);
+}
+
+
+#endif //_EPOCHRECLAMATION_HPP_
@@ -0,0 +1,236 @@
+/*! \file FastRandom.hpp
+ * \brief Cheap per-thread random generators for the benchmark loops (--rng)
+ *
+ * The test loops draw three to five numbers per operation. With
+ * std::mt19937 behind std::uniform_int_distribution that is a visible share
+ * of each iteration, so the loops are templated on the generator and can
+ * run on one of:
+ *
+ *   std::mt19937   the original generator; random_range() keeps using
+ *                  std::uniform_int_distribution so the stream is unchanged
+ *   xoshiro256pp   xoshiro256++ (Blackman and Vigna), 4 words of state
+ *   wyrand         one 64-bit add and one 128-bit multiply per draw
+ *
+ * and wrap any of them in replay<> to draw from a buffer generated before
+ * the timed region (--rng_stream).
+ */
+
+#ifndef _FASTRANDOM_HPP_
+#define _FASTRANDOM_HPP_
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+#include <type_traits>
+
+
+/*!
+ * \brief splitmix64 step, used to spread a small seed over a generator's state.
+ */
+static inline uint64_t splitmix64(uint64_t& x)
+{
+	uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/*!
+ * \class xoshiro256pp
+ *
+ * \brief xoshiro256++ as a UniformRandomBitGenerator.
+ */
+class xoshiro256pp
+{
+public:
+	typedef uint64_t result_type;
+
+	explicit xoshiro256pp(uint64_t seed)
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			s[i] = splitmix64(seed);
+		}
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+	result_type operator()()
+	{
+		uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+		uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return result;
+	}
+
+private:
+	uint64_t s[4];
+
+	static uint64_t rotl(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+};
+
+/*!
+ * \class wyrand
+ *
+ * \brief wyrand (from wyhash) as a UniformRandomBitGenerator.
+ */
+class wyrand
+{
+public:
+	typedef uint64_t result_type;
+
+	explicit wyrand(uint64_t seed) : state(seed)
+	{
+		state = splitmix64(state);
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+	result_type operator()()
+	{
+		state += 0xa0761d6478bd642fULL;
+		__uint128_t t = (__uint128_t)state * (state ^ 0xe7037ed1a0b428dbULL);
+		return (uint64_t)(t >> 64) ^ (uint64_t)t;
+	}
+
+private:
+	uint64_t state;
+};
+
+/*!
+ * \class replay
+ *
+ * \brief Hands out a pre-generated buffer of G's output, cyclically.
+ *
+ * The buffer is filled in the constructor, by the thread that will use it,
+ * so it is first-touched on that thread's node; a draw is then one load.
+ * After count draws the sequence repeats, which is harmless as long as
+ * count is large next to the structures' working set.
+ */
+template<typename G>
+class replay
+{
+public:
+	typedef typename G::result_type result_type;
+
+	/*!
+	 * \param[in] seed Seed for G.
+	 * \param[in] count Values to generate; rounded up to a power of two.
+	 */
+	replay(uint64_t seed, size_t count) : pos(0)
+	{
+		size_t size = 1;
+		while(size < count)
+		{
+			size <<= 1;
+		}
+		mask = size - 1;
+		values.resize(size);
+		G gen(seed);
+		for(size_t i = 0; i < size; i++)
+		{
+			values[i] = gen();
+		}
+	}
+
+	static constexpr result_type min() { return G::min(); }
+	static constexpr result_type max() { return G::max(); }
+
+	result_type operator()()
+	{
+		return values[pos++ & mask];
+	}
+
+private:
+	std::vector<result_type> values;
+	size_t mask;
+	size_t pos;
+};
+
+template<typename G> struct is_replay : std::false_type {};
+template<typename G> struct is_replay<replay<G>> : std::true_type {};
+
+/*!
+ * \brief Uniform int in [lo, hi].
+ *
+ * 32-bit generators (std::mt19937) go through std::uniform_int_distribution,
+ * so their streams match the loops' original ones. 64-bit generators use
+ * Lemire's multiply-shift with rejection ("Fast Random Integer Generation
+ * in an Interval"), which almost never needs the division.
+ */
+template<typename G>
+static inline int random_range(G& gen, int lo, int hi)
+{
+	if constexpr(G::max() <= 0xffffffffULL)
+	{
+		return std::uniform_int_distribution<int>(lo, hi)(gen);
+	}
+	else
+	{
+		uint64_t range = uint64_t(int64_t(hi) - lo) + 1;
+		__uint128_t m = (__uint128_t)gen() * range;
+		uint64_t low = (uint64_t)m;
+		if(low < range)
+		{
+			uint64_t threshold = (0 - range) % range;
+			while(low < threshold)
+			{
+				m = (__uint128_t)gen() * range;
+				low = (uint64_t)m;
+			}
+		}
+		return int(lo + int64_t(m >> 64));
+	}
+}
+
+/*!
+ * \brief Uniform double in [0, 1), same split between generators as random_range().
+ */
+template<typename G>
+static inline double random_unit(G& gen)
+{
+	if constexpr(G::max() <= 0xffffffffULL)
+	{
+		return std::uniform_real_distribution<double>(0.0, 1.0)(gen);
+	}
+	else
+	{
+		return double(gen() >> 11) * 0x1.0p-53;
+	}
+}
+
+/*!
+ * \class IntRange
+ *
+ * \brief Drop-in for std::uniform_int_distribution<> built on random_range().
+ */
+class IntRange
+{
+public:
+	IntRange(int lo, int hi) : lo(lo), hi(hi) {}
+
+	template<typename G>
+	int operator()(G& gen)
+	{
+		return random_range(gen, lo, hi);
+	}
+
+private:
+	int lo;
+	int hi;
+};
+
+
+#endif //_FASTRANDOM_HPP_
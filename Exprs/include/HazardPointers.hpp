@@ -0,0 +1,226 @@
+/*! \file HazardPointers.hpp
+ * \brief Hazard pointer reclamation for the lock-free data structures
+ *
+ */
+
+#ifndef _HAZARDPOINTERS_HPP_
+#define _HAZARDPOINTERS_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+
+/*!
+ * \class HazardPointers
+ *
+ * \brief Global hazard pointer domain shared by LockFreeStack and LockFreeQueue.
+ *
+ * Every thread owns one record of SLOTS hazard pointers, claimed on its
+ * first protect() and given back when the thread exits. A node that has
+ * been unlinked is handed to retire() and is only deleted once no record
+ * publishes it. Because a published node can never be freed and reused,
+ * a CAS on a protected pointer cannot succeed against a recycled address,
+ * which is what keeps the Treiber pop and the Michael-Scott del free of ABA.
+ */
+
+class HazardPointers
+{
+public:
+	static const int SLOTS = 2;             //< hazard pointers per thread (MS queue needs two)
+	static const int MAX_THREADS = 512;     //< records in the domain
+	static const int SCAN_THRESHOLD = 2 * SLOTS * 64; //< retired nodes before a thread scans
+
+	/*!
+	 * \brief Publish the current value of src in slot and return it.
+	 *
+	 * Re-reads src until the published value is still the one stored there,
+	 * so the caller may dereference the result until clear() is called.
+	 */
+	template<typename T>
+	static T* protect(int slot, const std::atomic<T*>& src);
+
+	/*!
+	 * \brief Drop the hazard pointer held in slot.
+	 */
+	static void clear(int slot);
+
+	/*!
+	 * \brief Hand an unlinked node to the domain for deferred deletion.
+	 */
+	template<typename T>
+	static void retire(T* node);
+
+private:
+	struct alignas(64) Record
+	{
+		std::atomic<bool> active{false};
+		std::atomic<void*> hp[SLOTS];
+	};
+
+	struct Retired
+	{
+		void* ptr;
+		void (*deleter)(void*);
+	};
+
+	struct ThreadState
+	{
+		Record* rec = nullptr;
+		std::vector<Retired> retired;
+		~ThreadState();
+	};
+
+	static Record records[MAX_THREADS];
+	static std::mutex orphan_lk;
+	static std::vector<Retired> orphans;   //< retired by threads that exited before they could free them
+
+	static ThreadState& state();
+	static Record* acquire();
+	static void scan(std::vector<Retired>& retired);
+
+	template<typename T>
+	static void destroy(void* p)
+	{
+		delete static_cast<T*>(p);
+	}
+};
+
+
+inline HazardPointers::Record HazardPointers::records[HazardPointers::MAX_THREADS];
+inline std::mutex HazardPointers::orphan_lk;
+inline std::vector<HazardPointers::Retired> HazardPointers::orphans;
+
+
+inline HazardPointers::ThreadState::~ThreadState()
+{
+	if(rec == nullptr)
+	{
+		return;
+	}
+	for(int i = 0; i < SLOTS; i++)
+	{
+		rec->hp[i].store(nullptr, std::memory_order_release);
+	}
+	scan(retired);
+	if(!retired.empty())
+	{
+		std::lock_guard<std::mutex> guard(orphan_lk);
+		orphans.insert(orphans.end(), retired.begin(), retired.end());
+	}
+	rec->active.store(false, std::memory_order_release);
+}
+
+inline HazardPointers::ThreadState& HazardPointers::state()
+{
+	thread_local ThreadState s;
+	if(s.rec == nullptr)
+	{
+		s.rec = acquire();
+	}
+	return s;
+}
+
+inline HazardPointers::Record* HazardPointers::acquire()
+{
+	for(int i = 0; i < MAX_THREADS; i++)
+	{
+		bool expected = false;
+		if(!records[i].active.load(std::memory_order_relaxed) &&
+		   records[i].active.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+		{
+			return &records[i];
+		}
+	}
+	std::cerr << "HazardPointers: more than " << MAX_THREADS << " live threads" << std::endl;
+	std::abort();
+}
+
+template<typename T>
+T* HazardPointers::protect(int slot, const std::atomic<T*>& src)
+{
+	std::atomic<void*>& hp = state().rec->hp[slot];
+	T* p = src.load(std::memory_order_relaxed);
+	while(true)
+	{
+		hp.store(p, std::memory_order_seq_cst);
+		T* again = src.load(std::memory_order_seq_cst);
+		if(again == p)
+		{
+			return p;
+		}
+		p = again;
+	}
+}
+
+inline void HazardPointers::clear(int slot)
+{
+	state().rec->hp[slot].store(nullptr, std::memory_order_release);
+}
+
+template<typename T>
+void HazardPointers::retire(T* node)
+{
+	ThreadState& s = state();
+	s.retired.push_back(Retired{node, &destroy<T>});
+	if(s.retired.size() >= SCAN_THRESHOLD)
+	{
+		scan(s.retired);
+	}
+}
+
+inline void HazardPointers::scan(std::vector<Retired>& retired)
+{
+	{
+		// Pick up whatever exited threads left behind so it is not leaked.
+		std::unique_lock<std::mutex> guard(orphan_lk, std::try_to_lock);
+		if(guard.owns_lock() && !orphans.empty())
+		{
+			retired.insert(retired.end(), orphans.begin(), orphans.end());
+			orphans.clear();
+		}
+	}
+
+	std::vector<void*> hazards;
+	hazards.reserve(MAX_THREADS * SLOTS);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for(int i = 0; i < MAX_THREADS; i++)
+	{
+		for(int j = 0; j < SLOTS; j++)
+		{
+			void* p = records[i].hp[j].load(std::memory_order_acquire);
+			if(p != nullptr)
+			{
+				hazards.push_back(p);
+			}
+		}
+	}
+
+	size_t kept = 0;
+	for(size_t i = 0; i < retired.size(); i++)
+	{
+		bool hazardous = false;
+		for(void* h : hazards)
+		{
+			if(h == retired[i].ptr)
+			{
+				hazardous = true;
+				break;
+			}
+		}
+		if(hazardous)
+		{
+			retired[kept++] = retired[i];
+		}
+		else
+		{
+			retired[i].deleter(retired[i].ptr);
+		}
+	}
+	retired.resize(kept);
+}
+
+
+#endif //_HAZARDPOINTERS_HPP_
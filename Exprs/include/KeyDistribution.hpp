@@ -0,0 +1,233 @@
+/*! \file KeyDistribution.hpp
+ * \brief Key and structure-index generators for the benchmark driver
+ *
+ * Selected per dimension on the command line: --key_dist for the keys a
+ * tree is searched for, --ds_dist for which structure of a pool an
+ * operation goes to.
+ */
+
+#ifndef _KEYDISTRIBUTION_HPP_
+#define _KEYDISTRIBUTION_HPP_
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include "FastRandom.hpp"
+
+
+/*!
+ * \class KeyDistribution
+ *
+ * \brief Draws ints from [lo, hi] in one of a few shapes.
+ *
+ * A shape is given as a spec, the name optionally followed by
+ * comma-separated parameters (commas, so meta.py's colon-separated value
+ * lists can sweep them):
+ *
+ *   uniform            every value equally likely
+ *   sequential         lo, lo+1, ..., hi, then lo again; the monotonic keys
+ *                      that turn an unbalanced BST into a list
+ *   zipf[,theta]       lo+i with probability ~ 1/(i+1)^theta, 0 < theta < 1,
+ *                      default 0.99 (Gray et al., "Quickly generating
+ *                      billion-record synthetic databases"); lo is hottest
+ *   hotspot[,x,y]      y% of draws go uniformly to the lowest x% of the range,
+ *                      the rest uniformly to the others; default 20,80
+ *   latest[,theta]     zipf distance back from a head that moves forward by
+ *                      one every draw, so the hot values are the ones issued
+ *                      most recently (YCSB's "latest")
+ *
+ * An instance keeps state (the sequential/latest cursor), so each thread
+ * owns its own, like it owns its generator. Draws go through random_range()
+ * and random_unit(), so any generator from FastRandom.hpp works.
+ */
+
+class KeyDistribution
+{
+public:
+	/*!
+	 * \brief True if spec names a shape and its parameters are in range.
+	 */
+	static bool known(const std::string& spec)
+	{
+		Kind kind;
+		std::vector<double> params;
+		return parse(spec, kind, params);
+	}
+
+	/*!
+	 * \param[in] spec Shape as described above; an invalid spec draws uniform.
+	 * \param[in] lo Smallest value.
+	 * \param[in] hi Largest value.
+	 */
+	KeyDistribution(const std::string& spec, int lo, int hi)
+	: kind(UNIFORM), lo(lo), hi(hi), next(lo),
+	  theta(0.99), zetan(0), eta(0), alpha(0), hotCount(0), hotPercent(0)
+	{
+		std::vector<double> params;
+		if(!parse(spec, kind, params))
+		{
+			kind = UNIFORM;
+			return;
+		}
+		if(kind == ZIPF || kind == LATEST)
+		{
+			if(!params.empty())
+			{
+				theta = params[0];
+			}
+			initZipf();
+		}
+		else if(kind == HOTSPOT)
+		{
+			double hotFraction = params.empty() ? 20 : params[0];
+			hotPercent = (params.size() < 2) ? 80 : params[1];
+			int64_t n = int64_t(hi) - lo + 1;
+			hotCount = int64_t(n * hotFraction / 100.0);
+			hotCount = (hotCount < 1) ? 1 : (hotCount > n ? n : hotCount);
+		}
+	}
+
+	template<typename G>
+	int operator()(G& gen)
+	{
+		switch(kind)
+		{
+		case SEQUENTIAL:
+			return advance();
+		case ZIPF:
+			return lo + zipfRank(gen);
+		case LATEST:
+		{
+			int64_t n = int64_t(hi) - lo + 1;
+			int64_t head = advance() - lo;
+			return lo + int((head - zipfRank(gen) + n) % n);
+		}
+		case HOTSPOT:
+		{
+			int64_t n = int64_t(hi) - lo + 1;
+			bool hot = (hotCount == n) || random_unit(gen) * 100.0 < hotPercent;
+			if(hot)
+			{
+				return random_range(gen, lo, int(lo + hotCount - 1));
+			}
+			return random_range(gen, int(lo + hotCount), hi);
+		}
+		default:
+			return random_range(gen, lo, hi);
+		}
+	}
+
+private:
+	enum Kind { UNIFORM, SEQUENTIAL, ZIPF, HOTSPOT, LATEST };
+
+	Kind kind;
+	int lo;
+	int hi;
+	int next;                                   //< sequential / latest cursor
+
+	//< zipf / latest constants, computed once per instance in O(hi - lo)
+	double theta;
+	double zetan;
+	double eta;
+	double alpha;
+
+	//< hotspot: the lowest hotCount values get hotPercent% of the draws
+	int64_t hotCount;
+	double hotPercent;
+
+	static bool parse(const std::string& spec, Kind& kind, std::vector<double>& params)
+	{
+		size_t comma = spec.find(',');
+		std::string name = spec.substr(0, comma);
+		while(comma != std::string::npos)
+		{
+			size_t end = spec.find(',', comma + 1);
+			try
+			{
+				size_t used = 0;
+				std::string field = spec.substr(comma + 1, end - comma - 1);
+				params.push_back(std::stod(field, &used));
+				if(used != field.size())
+				{
+					return false;
+				}
+			}
+			catch(const std::logic_error&)
+			{
+				return false;
+			}
+			comma = end;
+		}
+
+		if(name == "uniform" || name == "sequential")
+		{
+			kind = (name == "uniform") ? UNIFORM : SEQUENTIAL;
+			return params.empty();
+		}
+		if(name == "zipf" || name == "latest")
+		{
+			kind = (name == "zipf") ? ZIPF : LATEST;
+			return params.empty() || (params.size() == 1 && params[0] > 0 && params[0] < 1);
+		}
+		if(name == "hotspot")
+		{
+			kind = HOTSPOT;
+			if(params.size() > 2)
+			{
+				return false;
+			}
+			for(double p : params)
+			{
+				if(p < 0 || p > 100)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		return false;
+	}
+
+	int advance()
+	{
+		int value = next;
+		next = (next == hi) ? lo : next + 1;
+		return value;
+	}
+
+	void initZipf()
+	{
+		double n = double(hi) - lo + 1;
+		for(int64_t i = 1; i <= int64_t(n); i++)
+		{
+			zetan += 1.0 / std::pow(double(i), theta);
+		}
+		double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+		alpha = 1.0 / (1.0 - theta);
+		eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+	}
+
+	template<typename G>
+	int zipfRank(G& gen)
+	{
+		double n = double(hi) - lo + 1;
+		double u = random_unit(gen);
+		double uz = u * zetan;
+		if(uz < 1.0)
+		{
+			return 0;
+		}
+		if(uz < 1.0 + std::pow(0.5, theta))
+		{
+			return (n > 1) ? 1 : 0;
+		}
+		int64_t rank = int64_t(n * std::pow(eta * u - eta + 1.0, alpha));
+		return int(rank < int64_t(n) ? rank : int64_t(n) - 1);
+	}
+};
+
+
+#endif //_KEYDISTRIBUTION_HPP_
@@ -0,0 +1,217 @@
+/*! \file KeySearch.hpp
+ * \brief Lower-bound kernels for sorted int keys
+ *
+ * The kernel is picked at compile time: AVX2 when built with -mavx2 (or
+ * -march=native on a machine that has it), otherwise SSE2, which every
+ * x86-64 target has, and a scalar loop everywhere else. Build with
+ * -DKEY_SEARCH_SCALAR to force the scalar loop for comparisons.
+ */
+
+#ifndef _KEYSEARCH_HPP_
+#define _KEYSEARCH_HPP_
+
+#include <cstdint>
+
+#if !defined(KEY_SEARCH_SCALAR) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
+
+
+namespace key_search
+{
+
+#if defined(KEY_SEARCH_SCALAR)
+static const char* const kernel_name = "scalar";
+#elif defined(__AVX2__)
+static const char* const kernel_name = "avx2";
+#elif defined(__SSE2__)
+static const char* const kernel_name = "sse2";
+#else
+static const char* const kernel_name = "scalar";
+#endif
+
+/*
+ * Compare results are -1 per matching lane; the kernels add the compare
+ * vectors and sum the lanes rather than movemask + popcount, because
+ * POPCNT is not part of the x86-64 baseline and would become a libcall.
+ */
+#if !defined(KEY_SEARCH_SCALAR) && defined(__SSE2__)
+static inline int lane_sum(__m128i v)
+{
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(v);
+}
+#endif
+
+#if !defined(KEY_SEARCH_SCALAR) && defined(__AVX2__)
+static inline int lane_sum(__m256i v)
+{
+	return lane_sum(_mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+#endif
+
+/*!
+ * \brief Number of the 16 ints at keys that are smaller than key.
+ *
+ * keys must point at 16 readable ints; they do not have to be sorted, but
+ * for a sorted line this is the lower-bound position.
+ */
+static inline int count_less16(const int* keys, int key)
+{
+#if defined(KEY_SEARCH_SCALAR)
+	int n = 0;
+	for(int i = 0; i < 16; i++)
+	{
+		n += (keys[i] < key);
+	}
+	return n;
+#elif defined(__AVX2__)
+	__m256i k = _mm256_set1_epi32(key);
+	__m256i lo = _mm256_loadu_si256((const __m256i*)keys);
+	__m256i hi = _mm256_loadu_si256((const __m256i*)(keys + 8));
+	return -lane_sum(_mm256_add_epi32(_mm256_cmpgt_epi32(k, lo), _mm256_cmpgt_epi32(k, hi)));
+#elif defined(__SSE2__)
+	__m128i k = _mm_set1_epi32(key);
+	__m128i c0 = _mm_cmpgt_epi32(k, _mm_loadu_si128((const __m128i*)keys));
+	__m128i c1 = _mm_cmpgt_epi32(k, _mm_loadu_si128((const __m128i*)(keys + 4)));
+	__m128i c2 = _mm_cmpgt_epi32(k, _mm_loadu_si128((const __m128i*)(keys + 8)));
+	__m128i c3 = _mm_cmpgt_epi32(k, _mm_loadu_si128((const __m128i*)(keys + 12)));
+	return -lane_sum(_mm_add_epi32(_mm_add_epi32(c0, c1), _mm_add_epi32(c2, c3)));
+#else
+	int n = 0;
+	for(int i = 0; i < 16; i++)
+	{
+		n += (keys[i] < key);
+	}
+	return n;
+#endif
+}
+
+/*!
+ * \brief Number of the 16 ints at keys that are smaller than or equal to key.
+ */
+static inline int count_less_equal16(const int* keys, int key)
+{
+#if defined(KEY_SEARCH_SCALAR)
+	int n = 0;
+	for(int i = 0; i < 16; i++)
+	{
+		n += (keys[i] <= key);
+	}
+	return n;
+#elif defined(__AVX2__)
+	__m256i k = _mm256_set1_epi32(key);
+	__m256i lo = _mm256_loadu_si256((const __m256i*)keys);
+	__m256i hi = _mm256_loadu_si256((const __m256i*)(keys + 8));
+	return 16 + lane_sum(_mm256_add_epi32(_mm256_cmpgt_epi32(lo, k), _mm256_cmpgt_epi32(hi, k)));
+#elif defined(__SSE2__)
+	__m128i k = _mm_set1_epi32(key);
+	__m128i c0 = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)keys), k);
+	__m128i c1 = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(keys + 4)), k);
+	__m128i c2 = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(keys + 8)), k);
+	__m128i c3 = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(keys + 12)), k);
+	return 16 + lane_sum(_mm_add_epi32(_mm_add_epi32(c0, c1), _mm_add_epi32(c2, c3)));
+#else
+	int n = 0;
+	for(int i = 0; i < 16; i++)
+	{
+		n += (keys[i] <= key);
+	}
+	return n;
+#endif
+}
+
+/*!
+ * \brief std::lower_bound over a sorted array, as an index.
+ *
+ * Branch-free halving narrows the range to 16 candidates, which are then
+ * counted with count_less16(). The 16-wide window is slid back inside the
+ * array near its end, so nothing past keys[n-1] is read.
+ *
+ * \return Index of the first key >= key, n if there is none.
+ */
+static inline int lower_bound(const int* keys, int n, int key)
+{
+	if(n < 16)
+	{
+		int pos = 0;
+		for(int i = 0; i < n; i++)
+		{
+			pos += (keys[i] < key);
+		}
+		return pos;
+	}
+	const int* base = keys;
+	int len = n;
+	while(len > 16)
+	{
+		int half = len / 2;
+		base = (base[half] < key) ? base + half : base;
+		len -= half;
+	}
+	// the answer lies in [base, base + len], len <= 16
+	const int* window = (base + 16 <= keys + n) ? base : keys + n - 16;
+	return (int)(window - keys) + count_less16(window, key);
+}
+
+/*!
+ * \brief lower_bound() for a batch of queries against one sorted array.
+ *
+ * Queries are walked GROUP at a time in lockstep, and each step prefetches
+ * the probes of the next one, so the cache misses of the group overlap
+ * instead of being taken one query after another.
+ *
+ * \param[in] keys Sorted array.
+ * \param[in] n Number of keys.
+ * \param[in] queries Keys to look up.
+ * \param[in] count Number of queries.
+ * \param[out] out out[i] = lower_bound(keys, n, queries[i]).
+ */
+static inline void lower_bound_batch(const int* keys, int n, const int* queries, int count, int* out)
+{
+	const int GROUP = 8;
+	if(n < 16)
+	{
+		for(int q = 0; q < count; q++)
+		{
+			out[q] = lower_bound(keys, n, queries[q]);
+		}
+		return;
+	}
+	int q = 0;
+	for(; q + GROUP <= count; q += GROUP)
+	{
+		const int* base[GROUP];
+		for(int g = 0; g < GROUP; g++)
+		{
+			base[g] = keys;
+		}
+		// every query of the group sees the same sequence of lengths
+		int len = n;
+		while(len > 16)
+		{
+			int half = len / 2;
+			for(int g = 0; g < GROUP; g++)
+			{
+				base[g] = (base[g][half] < queries[q + g]) ? base[g] + half : base[g];
+				__builtin_prefetch(base[g] + (len - half) / 2);
+			}
+			len -= half;
+		}
+		for(int g = 0; g < GROUP; g++)
+		{
+			const int* window = (base[g] + 16 <= keys + n) ? base[g] : keys + n - 16;
+			out[q + g] = (int)(window - keys) + count_less16(window, queries[q + g]);
+		}
+	}
+	for(; q < count; q++)
+	{
+		out[q] = lower_bound(keys, n, queries[q]);
+	}
+}
+
+} // namespace key_search
+
+
+#endif //_KEYSEARCH_HPP_
@@ -0,0 +1,193 @@
+/*! \file LatencyHistogram.hpp
+ * \brief Log-bucketed (HDR-style) latency histogram for the benchmark harness
+ *
+ */
+
+#ifndef _LATENCYHISTOGRAM_HPP_
+#define _LATENCYHISTOGRAM_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <x86intrin.h>
+
+
+/*!
+ * \class LatencyHistogram
+ *
+ * \brief Fixed-size histogram of TSC cycle counts.
+ *
+ * Values below 2^SUB_BITS get a bucket each; above that every power of
+ * two is split into 2^SUB_BITS equal sub-buckets, so any recorded value
+ * is reported within 1/2^SUB_BITS (about 6%) of its true value. record()
+ * is a couple of shifts and an increment, and the whole table is a flat
+ * array, so one histogram per thread can be merged with a plain sum.
+ */
+
+class LatencyHistogram
+{
+public:
+	static const int SUB_BITS = 4;
+	static const int SUB = 1 << SUB_BITS;
+	static const int NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+	LatencyHistogram();
+
+	/*!
+	 * \brief Add one sample (in cycles).
+	 */
+	void record(uint64_t cycles);
+
+	/*!
+	 * \brief Add every sample of other into this histogram.
+	 */
+	void merge(const LatencyHistogram &other);
+
+	void reset();
+
+	/*!
+	 * \brief Smallest recorded bucket value v such that at least p percent of the samples are <= v.
+	 *
+	 * \param[in] p Percentile in [0, 100].
+	 * \return Upper bound (in cycles) of the bucket holding the percentile, 0 if empty.
+	 */
+	uint64_t percentile(double p) const;
+
+	uint64_t getCount() const { return count; }
+	uint64_t getMax() const { return maxValue; }
+
+private:
+	uint64_t counts[NUM_BUCKETS];
+	uint64_t count;
+	uint64_t maxValue;
+
+	static int bucketOf(uint64_t v);
+	static uint64_t bucketHigh(int idx);
+};
+
+
+inline LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+inline void LatencyHistogram::reset()
+{
+	memset(counts, 0, sizeof(counts));
+	count = 0;
+	maxValue = 0;
+}
+
+inline int LatencyHistogram::bucketOf(uint64_t v)
+{
+	if(v < (uint64_t)SUB)
+	{
+		return (int)v;
+	}
+	int e = 63 - __builtin_clzll(v);           // e >= SUB_BITS
+	int sub = (int)((v >> (e - SUB_BITS)) & (SUB - 1));
+	return (e - SUB_BITS + 1) * SUB + sub;
+}
+
+inline uint64_t LatencyHistogram::bucketHigh(int idx)
+{
+	if(idx < SUB)
+	{
+		return (uint64_t)idx;
+	}
+	int e = idx / SUB + SUB_BITS - 1;
+	uint64_t sub = (uint64_t)(idx % SUB);
+	uint64_t low = ((uint64_t)SUB + sub) << (e - SUB_BITS);
+	return low + ((uint64_t)1 << (e - SUB_BITS)) - 1;
+}
+
+inline void LatencyHistogram::record(uint64_t cycles)
+{
+	counts[bucketOf(cycles)]++;
+	count++;
+	if(cycles > maxValue)
+	{
+		maxValue = cycles;
+	}
+}
+
+inline void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+	for(int i = 0; i < NUM_BUCKETS; i++)
+	{
+		counts[i] += other.counts[i];
+	}
+	count += other.count;
+	if(other.maxValue > maxValue)
+	{
+		maxValue = other.maxValue;
+	}
+}
+
+inline uint64_t LatencyHistogram::percentile(double p) const
+{
+	if(count == 0)
+	{
+		return 0;
+	}
+	uint64_t target = (uint64_t)((p / 100.0) * count + 0.5);
+	if(target < 1)
+	{
+		target = 1;
+	}
+	uint64_t seen = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++)
+	{
+		seen += counts[i];
+		if(seen >= target)
+		{
+			uint64_t high = bucketHigh(i);
+			return high < maxValue ? high : maxValue;
+		}
+	}
+	return maxValue;
+}
+
+
+/*!
+ * \brief Serialized TSC read for the start of a timed region.
+ */
+static inline uint64_t tsc_begin()
+{
+	_mm_lfence();
+	return __rdtsc();
+}
+
+/*!
+ * \brief TSC read that waits for the timed region to retire.
+ */
+static inline uint64_t tsc_end()
+{
+	unsigned aux;
+	uint64_t t = __rdtscp(&aux);
+	_mm_lfence();
+	return t;
+}
+
+/*!
+ * \brief TSC ticks per nanosecond, measured once against steady_clock.
+ */
+static inline double tsc_per_ns()
+{
+	static double ratio = 0.0;
+	if(ratio == 0.0)
+	{
+		auto c0 = std::chrono::steady_clock::now();
+		uint64_t t0 = tsc_begin();
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		uint64_t t1 = tsc_end();
+		auto c1 = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(c1 - c0).count();
+		ratio = (double)(t1 - t0) / ns;
+	}
+	return ratio;
+}
+
+
+#endif //_LATENCYHISTOGRAM_HPP_
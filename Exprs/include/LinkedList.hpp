@@ -23,6 +23,12 @@ private:
 	Node *tail;
 	int length;
 
+	/*!
+	 * \brief Chain count nodes holding value(0) .. value(count-1) and splice them behind tail once
+	 */
+	template<typename Value>
+	void append_chain(int count, Value value);
+
 
 public:
 	/*!
@@ -57,7 +63,8 @@ public:
 	/*!
 	 * \brief append function for adding LinkedList variables to the end of the list
 	 *
-	 * The append function adds a new LinkedList node to the end of the LinkedList. 
+	 * The append function adds a new LinkedList node to the end of the LinkedList.
+	 * The node is linked behind tail, so append is O(1).
 	 *
 	 * \param[in] data Data to be added to tail of LinkedList. This data is wrapped by a Node.
 	 * 
@@ -67,6 +74,27 @@ public:
 
 	void append(int data);
 
+	/*!
+	 * \brief Bulk version of LinkedList::append() for prefilling
+	 *
+	 * Appends count nodes holding data behind tail, updating tail once at the end.
+	 *
+	 * \param[in] data Data stored in every new node.
+	 * \param[in] count Number of nodes to append.
+	 */
+	void append_n(int data, int count);
+
+	/*!
+	 * \brief Append a batch of values in one call
+	 *
+	 * Equivalent to calling LinkedList::append() for values[0] .. values[count-1],
+	 * but the chain is built locally and spliced behind tail once.
+	 *
+	 * \param[in] values Data for the new nodes, in list order.
+	 * \param[in] count Number of values.
+	 */
+	void append_range(const int *values, int count);
+
 	/*!
 	 * \brief prepend function for adding LinkedList variables to the beginning of the list
 	 *
@@ -98,14 +126,24 @@ public:
 	/*!
 	 * \brief removeTail function for deleting the tail element of LinkedList
 	 * 
-	 * This function utilizes the tail member of the Linked List class to 
-	 * remove the tail from the list.
+	 * The list is singly linked, so finding the node before tail still takes a
+	 * walk from head; tail is then moved back to that node.
 	 *
 	 * \return The value deleted from the list.
 	 */
 
 	int removeTail();
 
+	/*!
+	 * \brief Remove up to n nodes from the head in one call
+	 *
+	 * \param[in] n Maximum number of nodes to remove.
+	 * \param[out] out If not NULL, receives the data of the removed nodes in list order.
+	 *
+	 * \return The number of nodes removed (less than n if the list ran out).
+	 */
+	int remove_n(int n, int *out = NULL);
+
 
 	/*!
 	 * \brief insertAtIndex function for adding LinkedList variables after a specific node
@@ -177,6 +215,10 @@ int LinkedList::removeHead()
 	}
 	Node *temp = head;
 	head = head->getLink();
+	if(head == NULL)
+	{
+		tail = NULL;
+	}
 	int data = temp->getData();
 	delete temp;
 	temp = NULL;
@@ -186,31 +228,80 @@ int LinkedList::removeHead()
 
 }
 
-void LinkedList::append(int data)
+int LinkedList::remove_n(int n, int *out)
 {
+	int removed = 0;
+	while(removed < n && head != NULL)
+	{
+		Node *temp = head;
+		head = head->getLink();
+		if(out != NULL)
+		{
+			out[removed] = temp->getData();
+		}
+		delete temp;
+		removed++;
+	}
 	if(head == NULL)
 	{
-		Node *newNode = new Node(data);
-		newNode->setLink(NULL);
+		tail = NULL;
+	}
+	length -= removed;
+	return removed;
+}
+
+void LinkedList::append(int data)
+{
+	Node *newNode = new Node(data, NULL);
+	if(tail == NULL)
+	{
 		head = newNode;
-		length++;
+	}
+	else
+	{
+		tail->setLink(newNode);
+	}
+	tail = newNode;
+	length++;
+}
+
+template<typename Value>
+void LinkedList::append_chain(int count, Value value)
+{
+	if(count <= 0)
+	{
 		return;
+	}
 
+	Node *chainHead = new Node(value(0), NULL);
+	Node *chainTail = chainHead;
+	for(int i = 1; i < count; i++)
+	{
+		Node *newNode = new Node(value(i), NULL);
+		chainTail->setLink(newNode);
+		chainTail = newNode;
 	}
 
-	Node *temp = head;
-	while(true)
+	if(tail == NULL)
 	{
-		if(temp->getLink() == NULL)
-		{
-			Node *newNode = new Node(data);
-			newNode->setLink(NULL);
-			temp->setLink(newNode);
-			length++;
-			return;
-		}
-		temp = temp->getLink();
+		head = chainHead;
+	}
+	else
+	{
+		tail->setLink(chainHead);
 	}
+	tail = chainTail;
+	length += count;
+}
+
+void LinkedList::append_n(int data, int count)
+{
+	append_chain(count, [data](int){ return data; });
+}
+
+void LinkedList::append_range(const int *values, int count)
+{
+	append_chain(count, [values](int i){ return values[i]; });
 }
 
 void LinkedList::prepend(int data)
@@ -218,6 +309,10 @@ void LinkedList::prepend(int data)
 	Node *newNode = new Node(data);
 	newNode->setLink(head);
 	head = newNode;
+	if(tail == NULL)
+	{
+		tail = newNode;
+	}
 	length++;
 }
 
@@ -228,6 +323,7 @@ void LinkedList::insertAfter(int existData, int newData)
 		Node *newNode = new Node(newData);
 		newNode->setLink(NULL);
 		head = newNode;
+		tail = newNode;
 		length++;
 		return;
 	}
@@ -240,6 +336,10 @@ void LinkedList::insertAfter(int existData, int newData)
 			Node *newNode = new Node(newData);
 			newNode->setLink(temp->getLink());
 			temp->setLink(newNode);
+			if(temp == tail)
+			{
+				tail = newNode;
+			}
 			length++;
 			return;
 		}
@@ -249,33 +349,31 @@ void LinkedList::insertAfter(int existData, int newData)
 
 int LinkedList::removeTail()
 {
-	/*
-	 * Could use the length variable, but I want to implement
-	 * it using pointers only.  Length is a debugging tool.
-	 */
 	if(head == NULL)
 	{
 		return -1;
 	}
 
-	Node *current = head;
-	Node *prev = NULL;
-	while(current != NULL)
+	int data = tail->getData();
+	if(head == tail)
 	{
-		if(current->getLink() == NULL)
-		{
-			int data = current->getData();
-			prev->setLink(NULL);
-			delete current;
-			length--;
-			current = NULL;
-			return data;
-		}
-		prev = current;
-		current = current->getLink();
+		delete head;
+		head = NULL;
+		tail = NULL;
+		length--;
+		return data;
 	}
 
-	return -2;
+	Node *prev = head;
+	while(prev->getLink() != tail)
+	{
+		prev = prev->getLink();
+	}
+	prev->setLink(NULL);
+	delete tail;
+	tail = prev;
+	length--;
+	return data;
 }
 
 void LinkedList::insertAtIndex(int index, int newData)
@@ -290,6 +388,7 @@ void LinkedList::insertAtIndex(int index, int newData)
 		Node *newNode = new Node(newData);
 		newNode->setLink(NULL);
 		head = newNode;
+		tail = newNode;
 		length++;
 		return;
 	}
@@ -301,9 +400,17 @@ void LinkedList::insertAtIndex(int index, int newData)
 	{
 		if(i == index)
 		{
+			// the new node always lands in front of an existing one, so tail is unchanged
 			Node *newNode = new Node(newData);
 			newNode->setLink(temp);
-			prev->setLink(newNode);
+			if(prev == NULL)
+			{
+				head = newNode;
+			}
+			else
+			{
+				prev->setLink(newNode);
+			}
 			length++;
 			return;
 		}
@@ -0,0 +1,161 @@
+/*! \file LockFreeQueue.hpp
+ * \brief Interface for a lock-free (Michael-Scott) Queue class
+ *
+ */
+
+#ifndef _LOCKFREEQUEUE_HPP_
+#define _LOCKFREEQUEUE_HPP_
+
+#include "AtomicNode.hpp"
+#include "HazardPointers.hpp"
+#include <atomic>
+#include <iostream>
+
+/*!
+ * \class LockFreeQueue
+ *
+ * \brief Michael-Scott queue with the same interface as \class Queue.
+ *
+ * front always points at a dummy node whose successor holds the oldest
+ * element, so add only touches rear and del only touches front. A lagging
+ * rear is swung forward by whichever thread notices it. del holds hazard
+ * pointers on the dummy and on its successor while it reads them; the old
+ * dummy is retired to \class HazardPointers once front has moved past it.
+ */
+
+class LockFreeQueue
+{
+private:
+	std::atomic<AtomicNode*> front;
+	std::atomic<AtomicNode*> rear;
+
+public:
+	/*!
+	 * \brief Default LockFreeQueue Constructor
+	 *
+	 * Allocates the initial dummy node.
+	 */
+	LockFreeQueue();
+
+	/*!
+	 * \brief LockFreeQueue Destructor
+	 *
+	 * Must only run once no other thread uses the queue; frees the dummy
+	 * and every remaining node directly.
+	 */
+	~LockFreeQueue();
+
+	/*!
+	 * \brief Remove the least recently added node.
+	 *
+	 * \return The data from the removed node, or -1 if the queue is empty.
+	 */
+	int del();
+
+	/*!
+	 * \brief Append data at the rear of the queue.
+	 *
+	 * \param[in] data Data to be added. This data is wrapped by an AtomicNode.
+	 */
+	void add(int);
+
+	/*!
+	 * \brief A function to display the contents of the Queue.
+	 *
+	 * Not safe against concurrent dels.
+	 */
+	void display();
+};
+
+LockFreeQueue::LockFreeQueue()
+{
+	AtomicNode *dummy = new AtomicNode();
+	front.store(dummy, std::memory_order_relaxed);
+	rear.store(dummy, std::memory_order_relaxed);
+}
+
+LockFreeQueue::~LockFreeQueue()
+{
+	AtomicNode *temp = front.load(std::memory_order_relaxed);
+	while(temp != NULL)
+	{
+		AtomicNode *next = temp->getLink();
+		delete temp;
+		temp = next;
+	}
+}
+
+int LockFreeQueue::del()
+{
+	while(true)
+	{
+		AtomicNode *first = HazardPointers::protect(0, front);
+		AtomicNode *last = rear.load(std::memory_order_acquire);
+		AtomicNode *next = HazardPointers::protect(1, first->linkRef());
+		if(first != front.load(std::memory_order_acquire))
+		{
+			continue;
+		}
+		if(next == NULL)
+		{
+			HazardPointers::clear(0);
+			HazardPointers::clear(1);
+			return -1;
+		}
+		if(first == last)
+		{
+			// rear lags behind a completed add; help it along
+			rear.compare_exchange_strong(last, next, std::memory_order_release, std::memory_order_relaxed);
+			continue;
+		}
+		int data = next->getData();
+		if(front.compare_exchange_strong(first, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			HazardPointers::clear(0);
+			HazardPointers::clear(1);
+			HazardPointers::retire(first);
+			return data;
+		}
+	}
+}
+
+void LockFreeQueue::add(int initData)
+{
+	AtomicNode *newNode = new AtomicNode(initData);
+	while(true)
+	{
+		AtomicNode *last = HazardPointers::protect(0, rear);
+		AtomicNode *next = last->getLink();
+		if(last != rear.load(std::memory_order_acquire))
+		{
+			continue;
+		}
+		if(next != NULL)
+		{
+			rear.compare_exchange_strong(last, next, std::memory_order_release, std::memory_order_relaxed);
+			continue;
+		}
+		if(last->linkRef().compare_exchange_weak(next, newNode, std::memory_order_release, std::memory_order_relaxed))
+		{
+			rear.compare_exchange_strong(last, newNode, std::memory_order_release, std::memory_order_relaxed);
+			HazardPointers::clear(0);
+			return;
+		}
+	}
+}
+
+void LockFreeQueue::display()
+{
+	AtomicNode *temp = front.load(std::memory_order_acquire)->getLink();
+	while(temp != NULL)
+	{
+		if(temp == front.load(std::memory_order_acquire)->getLink())
+		{
+			std::cout << "FRONT " << std::endl;
+		}
+		std::cout << temp->getData() << std::endl;
+		temp = temp->getLink();
+	}
+}
+
+#endif //_LOCKFREEQUEUE_HPP_
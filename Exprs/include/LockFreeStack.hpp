@@ -0,0 +1,148 @@
+/*! \file LockFreeStack.hpp
+ * \brief Interface for a lock-free (Treiber) Stack class
+ *
+ */
+
+#ifndef _LOCKFREESTACK_HPP_
+#define _LOCKFREESTACK_HPP_
+
+#include "AtomicNode.hpp"
+#include "HazardPointers.hpp"
+#include <atomic>
+#include "iostream"
+using namespace std;
+
+
+/*!
+ * \class LockFreeStack
+ *
+ * \brief Treiber stack with the same interface as \class Stack.
+ *
+ * push and pop are a single CAS on top, so callers do not need a lock
+ * around them. pop protects the node it is about to unlink with a hazard
+ * pointer, so the node cannot be freed (and its address recycled) between
+ * reading top->link and the CAS; unlinked nodes are retired to
+ * \class HazardPointers instead of deleted in place.
+ */
+
+class LockFreeStack
+{
+
+private:
+	std::atomic<AtomicNode*> top; //< Pointer to the top of the Stack
+
+
+public:
+	/*!
+	 * \brief Default LockFreeStack Constructor
+	 *
+	 */
+	LockFreeStack();
+
+	/*!
+	 * \brief LockFreeStack Destructor
+	 *
+	 * Must only run once no other thread uses the stack; frees the
+	 * remaining nodes directly.
+	 */
+	~LockFreeStack();
+
+	/*!
+	 * \brief Remove the most recently pushed node.
+	 *
+	 * \return The data from the removed node, or -1 if the stack is empty.
+	 */
+	int pop();
+
+	/*!
+	 * \brief Push data on top of the stack.
+	 *
+	 * \param[in] data Data to be added to top of stack. This data is wrapped by an AtomicNode.
+	 */
+	void push(int);
+
+
+	/*!
+	 * \brief A function to display the contents of the stack.
+	 *
+	 * Not safe against concurrent pops.
+	 */
+	void display();
+
+
+};
+
+
+LockFreeStack::LockFreeStack()
+{
+	top.store(nullptr, std::memory_order_relaxed);
+}
+
+
+LockFreeStack::~LockFreeStack()
+{
+	AtomicNode *temp = top.load(std::memory_order_relaxed);
+	while(temp != NULL)
+	{
+		AtomicNode *next = temp->getLink();
+		delete temp;
+		temp = next;
+	}
+}
+
+
+int LockFreeStack::pop()
+{
+	while(true)
+	{
+		AtomicNode *oldTop = HazardPointers::protect(0, top);
+		if(oldTop == NULL)
+		{
+			HazardPointers::clear(0);
+			return -1;
+		}
+		AtomicNode *next = oldTop->getLink();
+		if(top.compare_exchange_weak(oldTop, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			HazardPointers::clear(0);
+			int data = oldTop->getData();
+			HazardPointers::retire(oldTop);
+			return data;
+		}
+	}
+}
+
+
+void LockFreeStack::push(int data)
+{
+	AtomicNode *newN = new AtomicNode(data);
+	AtomicNode *oldTop = top.load(std::memory_order_relaxed);
+	do
+	{
+		newN->setLink(oldTop);
+	} while(!top.compare_exchange_weak(oldTop, newN, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void LockFreeStack::display()
+{
+	AtomicNode *temp = top.load(std::memory_order_acquire);
+	if(temp == NULL)
+	{
+		std::cout << "Stack Empty!!" << std::endl;
+		return;
+	}
+
+	int i = 0;
+	while (temp != NULL)
+	{
+		if(i == 0)
+			std::cout << "TOP ";
+
+		std::cout << temp->getData() << std::endl;
+		temp = temp->getLink();
+		i++;
+	}
+}
+
+
+#endif //_LOCKFREESTACK_HPP_
@@ -0,0 +1,163 @@
+/*! \file OpTrace.hpp
+ * \brief Binary operation traces for the benchmark's replay mode (--trace)
+ *
+ * A trace is a header followed by one fixed-size section of records per
+ * thread. Every field is fixed-width and the records start 32 bytes in, so
+ * the file is used by mmap()ing it as is; Examples/trace_gen.cpp writes
+ * them.
+ */
+
+#ifndef _OPTRACE_HPP_
+#define _OPTRACE_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+static const char OP_TRACE_MAGIC[8] = {'N', 'U', 'M', 'A', 'T', 'R', 'C', '1'};
+
+/*
+ * What the records of a trace drive. The op codes of a record depend on it:
+ *   OP_TRACE_POOL  stack, queue, ll, lfstack, lfqueue: 0 insert, 1 remove
+ *   OP_TRACE_BST   bst, btree, avl: 0 lookup, 1 + (txn % 4) for the four
+ *                  remove/insert transactions of the test loop
+ */
+enum op_trace_kind : uint32_t {
+	OP_TRACE_POOL = 0,
+	OP_TRACE_BST = 1,
+};
+
+struct op_trace_header {
+	char magic[8];              //< OP_TRACE_MAGIC
+	uint32_t kind;              //< op_trace_kind
+	uint32_t sections;          //< one per thread; thread tid replays section tid % sections
+	uint32_t ds_per_node;       //< structures per pool half the ds indices were drawn for
+	uint32_t keyspace;          //< keys are in [0, keyspace]
+	uint64_t ops_per_section;
+};
+
+struct op_record {
+	uint8_t op;                 //< see op_trace_kind
+	uint8_t node;               //< pool half the op goes to (pool ops and bst lookups)
+	uint16_t reserved;
+	int32_t ds;                 //< structure index; the first tree of a bst transaction
+	int32_t ds2;                //< second tree of a bst transaction
+	int32_t key;                //< bst key; pool ops push ds as the test loops do
+};
+
+static_assert(sizeof(op_trace_header) == 32, "op_trace_header is part of the file format");
+static_assert(sizeof(op_record) == 16, "op_record is part of the file format");
+
+
+/*!
+ * \class op_trace_file
+ *
+ * \brief Read-only mapping of a trace file.
+ */
+class op_trace_file
+{
+public:
+	op_trace_file() : base(nullptr), length(0) {}
+
+	~op_trace_file()
+	{
+		if(base != nullptr)
+		{
+			munmap(base, length);
+		}
+	}
+
+	op_trace_file(const op_trace_file&) = delete;
+	op_trace_file& operator=(const op_trace_file&) = delete;
+
+	/*!
+	 * \brief Map path and check its header and size.
+	 *
+	 * \param[out] error Reason when false is returned.
+	 */
+	bool open(const std::string& path, std::string& error)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if(fd < 0)
+		{
+			error = "cannot open " + path;
+			return false;
+		}
+		struct stat st;
+		if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(op_trace_header))
+		{
+			close(fd);
+			error = path + " is too short for a trace header";
+			return false;
+		}
+		length = st.st_size;
+		base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(base == MAP_FAILED)
+		{
+			base = nullptr;
+			error = "cannot map " + path;
+			return false;
+		}
+
+		const op_trace_header& h = header();
+		if(std::memcmp(h.magic, OP_TRACE_MAGIC, sizeof(OP_TRACE_MAGIC)) != 0)
+		{
+			error = path + " is not a trace file";
+			return false;
+		}
+		uint64_t records = uint64_t(h.sections) * h.ops_per_section;
+		if(h.sections == 0 || h.ops_per_section == 0 ||
+		   length != sizeof(op_trace_header) + records * sizeof(op_record))
+		{
+			error = path + " has a truncated or empty record area";
+			return false;
+		}
+		return true;
+	}
+
+	const op_trace_header& header() const
+	{
+		return *static_cast<const op_trace_header*>(base);
+	}
+
+	/*!
+	 * \brief First record of the section thread tid replays.
+	 */
+	const op_record* section(int tid) const
+	{
+		const op_record* records = reinterpret_cast<const op_record*>(static_cast<const char*>(base) + sizeof(op_trace_header));
+		return records + uint64_t(tid % header().sections) * header().ops_per_section;
+	}
+
+private:
+	void* base;
+	size_t length;
+};
+
+/*!
+ * \brief Write a trace: header, then sections back to back.
+ *
+ * \return False if the file could not be written completely.
+ */
+static inline bool write_op_trace(const std::string& path, const op_trace_header& header, const std::vector<op_record>& records)
+{
+	FILE* out = std::fopen(path.c_str(), "wb");
+	if(out == nullptr)
+	{
+		return false;
+	}
+	bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+	          std::fwrite(records.data(), sizeof(op_record), records.size(), out) == records.size();
+	return (std::fclose(out) == 0) && ok;
+}
+
+
+#endif //_OPTRACE_HPP_
@@ -4,6 +4,7 @@
 
 #include "Node.hpp"
 #include <iostream>
+#include <span>
 
 class Queue
 {
@@ -11,6 +12,16 @@ private:
 	Node *front;
 	Node *rear;
 
+	/*!
+	 * \brief Allocate count nodes holding value(0) .. value(count-1), in queue order
+	 *
+	 * \param[out] last Set to the node holding value(count-1).
+	 *
+	 * \return The first node, or NULL if count is not positive.
+	 */
+	template<typename Value>
+	static Node *build_chain(int count, Value value, Node **last);
+
 public:
 
 	/*!
@@ -55,6 +66,55 @@ public:
 
 	void add(int);
 
+	/*!
+	 * \brief Bulk version of Queue::add() for prefilling
+	 *
+	 * Adds the values first, first+1, ..., first+count-1. The new nodes are
+	 * chained locally and linked behind rear once by Queue::add_chain(),
+	 * instead of re-reading rear for every element.
+	 *
+	 * \param[in] first Value of the first node added.
+	 * \param[in] count Number of nodes to add.
+	 */
+	void add_range(int first, int count);
+
+	/*!
+	 * \brief Allocate the nodes for Queue::add_chain()
+	 *
+	 * Builds a chain holding data without touching any queue, so the
+	 * allocations can happen before the caller takes its lock.
+	 *
+	 * \param[in] data Values to chain, in queue order.
+	 * \param[out] last Set to the node holding the last value, whose link is NULL.
+	 *
+	 * \return The node holding data[0], or NULL if data is empty.
+	 */
+	static Node *make_chain(std::span<const int> data, Node **last);
+
+	/*!
+	 * \brief Link a chain from Queue::make_chain() behind rear
+	 *
+	 * Only front or the link of rear, and rear itself, are written, so this
+	 * is all a caller has to do inside its critical section.
+	 *
+	 * \param[in] first First node of the chain; may be NULL.
+	 * \param[in] last Last node of the chain, the new rear.
+	 */
+	void add_chain(Node *first, Node *last);
+
+	/*!
+	 * \brief Detach up to n nodes from front as one chain
+	 *
+	 * The nodes are not freed; the caller reads and deletes them, following
+	 * Node::getLink() to the NULL that ends the chain, after releasing
+	 * whatever lock guards the queue.
+	 *
+	 * \param[in] n Number of nodes to detach.
+	 * \param[out] count Number of nodes detached, less than n if the queue ran empty.
+	 *
+	 * \return The former front node, in queue order; NULL if the queue was empty.
+	 */
+	Node *del_chain(int n, int *count);
 
 	/*!
 	 * \brief A function to display the contents of the Queue.
@@ -121,6 +181,77 @@ void Queue::add(int initData)
 
 }
 
+template<typename Value>
+Node *Queue::build_chain(int count, Value value, Node **last)
+{
+	if(count <= 0)
+	{
+		return NULL;
+	}
+	Node *chainFront = new Node(value(0), NULL);
+	Node *chainRear = chainFront;
+	for(int i = 1; i < count; i++)
+	{
+		Node *newNode = new Node(value(i), NULL);
+		chainRear->setLink(newNode);
+		chainRear = newNode;
+	}
+	*last = chainRear;
+	return chainFront;
+}
+
+void Queue::add_range(int first, int count)
+{
+	Node *chainRear = NULL;
+	Node *chainFront = build_chain(count, [first](int i){ return first + i; }, &chainRear);
+	add_chain(chainFront, chainRear);
+}
+
+Node *Queue::make_chain(std::span<const int> data, Node **last)
+{
+	return build_chain(int(data.size()), [data](int i){ return data[i]; }, last);
+}
+
+void Queue::add_chain(Node *first, Node *last)
+{
+	if(first == NULL)
+	{
+		return;
+	}
+	if(front == NULL)
+	{
+		front = first;
+	}
+	else
+	{
+		rear->setLink(first);
+	}
+	rear = last;
+}
+
+Node *Queue::del_chain(int n, int *count)
+{
+	Node *chain = front;
+	Node *chainRear = NULL;
+	int removed = 0;
+	while(removed < n && front != NULL)
+	{
+		chainRear = front;
+		front = front->getLink();
+		removed++;
+	}
+	if(front == NULL)
+	{
+		rear = NULL;
+	}
+	if(chainRear != NULL)
+	{
+		chainRear->setLink(NULL);
+	}
+	*count = removed;
+	return removed > 0 ? chain : NULL;
+}
+
 void Queue::display()
 {
 	Node *temp = front;
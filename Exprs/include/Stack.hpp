@@ -10,6 +10,7 @@
 
 #include "Node.hpp"
 #include "iostream"	
+#include <span>
 using namespace std;
 
 
@@ -73,6 +74,45 @@ public:
 	 */
 	void push(int);
 
+	/*!
+	 * \brief Allocate the nodes for Stack::push_chain()
+	 *
+	 * Builds a chain holding data without touching any stack, so the
+	 * allocations can happen before the caller takes its lock. The last
+	 * value of data is at the returned end, as if pushed one by one.
+	 *
+	 * \param[in] data Values to chain, first one pushed first.
+	 * \param[out] last Set to the node holding data[0], whose link is NULL.
+	 *
+	 * \return The node holding the last value, or NULL if data is empty.
+	 */
+	static Node *make_chain(std::span<const int> data, Node **last);
+
+	/*!
+	 * \brief Link a chain from Stack::make_chain() above top
+	 *
+	 * Only top and the link of last are written, so this is all a caller
+	 * has to do inside its critical section.
+	 *
+	 * \param[in] first Node that becomes the new top; may be NULL.
+	 * \param[in] last Bottom node of the chain.
+	 */
+	void push_chain(Node *first, Node *last);
+
+	/*!
+	 * \brief Detach up to n nodes from top as one chain
+	 *
+	 * The nodes are not freed; the caller reads and deletes them, following
+	 * Node::getLink() to the NULL that ends the chain, after releasing
+	 * whatever lock guards the stack.
+	 *
+	 * \param[in] n Number of nodes to detach.
+	 * \param[out] count Number of nodes detached, less than n if the stack ran empty.
+	 *
+	 * \return The former top node, in pop order; NULL if the stack was empty.
+	 */
+	Node *pop_chain(int n, int *count);
+
 
 	/*!
 	 * \brief A function to display the contents of the stack.
@@ -140,6 +180,51 @@ void Stack::push(int data)
 
 }
 
+Node *Stack::make_chain(std::span<const int> data, Node **last)
+{
+	Node *chainTop = NULL;
+	for(size_t i = 0; i < data.size(); i++)
+	{
+		chainTop = new Node(data[i], chainTop);
+		if(i == 0)
+		{
+			*last = chainTop;
+		}
+	}
+	return chainTop;
+}
+
+
+void Stack::push_chain(Node *first, Node *last)
+{
+	if(first == NULL)
+	{
+		return;
+	}
+	last->setLink(top);
+	top = first;
+}
+
+
+Node *Stack::pop_chain(int n, int *count)
+{
+	Node *chain = top;
+	Node *chainBottom = NULL;
+	int popped = 0;
+	while(popped < n && top != NULL)
+	{
+		chainBottom = top;
+		top = top->getLink();
+		popped++;
+	}
+	if(chainBottom != NULL)
+	{
+		chainBottom->setLink(NULL);
+	}
+	*count = popped;
+	return popped > 0 ? chain : NULL;
+}
+
 void Stack::display()
 {
 	if(top == NULL)
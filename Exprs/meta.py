@@ -34,7 +34,8 @@ def isInt(s):
 
 def parseCommandLine():
 	parser = ArgumentParser("metacmd.py CMD OPTION1 OPTION2 [--meta METAOPTION:VALUE1:VALUE2:INT1...INT2] [-h] [--printOnly]\
-\nMetacmd will in invoke CMD on all combinations of meta options and their values.  Non meta options will be passed as is to the command.")	
+\nMetacmd will in invoke CMD on all combinations of meta options and their values.  Non meta options will be passed as is to the command.\
+\nValues may carry comma-separated parameters, e.g. --meta key_dist:uniform:zipf,0.9:hotspot,10,90")	
 	parser.add_argument("--meta", action="append",dest="metas",help="meta options to iterate over. Flag comes first in colon separated list.  Can use ellipses in between integers to represent all integers in the range.", metavar="OPTION:VALUE1,VALUE2,VALUE3", default = [])
 	parser.add_argument("--printOnly", action="store_true",dest="printOnly",help="show commands, but don't actually execute them", default = False)
 	(options, remains) = parser.parse_known_args()
@@ -102,7 +103,7 @@ if __name__ == "__main__":
 		vals = parseMetaValues(meta)
 
 		if(opt in metaDict):
-			metaDict[opt].append(vals)
+			metaDict[opt].extend(vals)
 		else:
 			metaDict[opt]=vals
 
@@ -127,8 +128,9 @@ if __name__ == "__main__":
 		print ("These commands would be run if --printOnly flag was dropped:")
 
 	for command in commands:
-		#print (command)
-		if(not options.printOnly):
+		if(options.printOnly):
+			print (command)
+		else:
 			result = os.system(command)
 			if(result!=0):
 				sys.exit(0)
@@ -0,0 +1,233 @@
+#pragma once
+#ifndef NUMASCHED_HPP
+#define NUMASCHED_HPP
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <numa.h>
+#include "numatype.hpp"     // get_numa_node_id
+#include "numathreads.hpp"  // numa_topology
+
+// Work-stealing task scheduler with one set of workers per NUMA node.
+//
+// Every worker owns a deque. submit_on(node, fn) queues fn on one of the
+// workers of that node (round-robin); submit_near(ptr, fn) looks up the
+// node backing ptr with get_numa_node_id and does the same, so a task runs
+// next to the memory it is going to touch. A worker takes its own newest
+// task first, then steals the oldest task of another worker: first from
+// workers on its own node, then from other nodes in order of increasing
+// numa_distance, so work only leaves a node once that node has none left.
+//
+// Tasks may submit further tasks. wait() returns once every submitted task
+// (including those) has finished. The destructor waits as well.
+class numa_scheduler {
+public:
+    using task_type = std::function<void()>;
+
+    explicit numa_scheduler(const std::vector<int>& nodes = numa_topology::nodes(), int threads_per_node = 0)
+        : node_ids(nodes) {
+        for (int k = 0; k < (int)node_ids.size(); ++k) {
+            std::vector<int> cpus = numa_topology::cpus_of(node_ids[k]);
+            int count = threads_per_node > 0 ? threads_per_node : std::max<int>(1, cpus.size());
+            node_workers.emplace_back();
+            for (int j = 0; j < count; ++j) {
+                node_workers[k].push_back((int)queues.size());
+                queues.emplace_back(new worker_queue());
+                worker_node.push_back(k);
+                worker_cpu.push_back(cpus.empty() ? -1 : cpus[j % cpus.size()]);
+            }
+            next_worker.emplace_back(new std::atomic<unsigned>(0));
+        }
+        build_steal_order();
+        for (int w = 0; w < (int)queues.size(); ++w) {
+            threads.emplace_back(&numa_scheduler::worker_loop, this, w);
+        }
+    }
+
+    ~numa_scheduler() {
+        wait();
+        {
+            std::lock_guard<std::mutex> guard(sleep_lk);
+            stopping = true;
+        }
+        sleep_cv.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    numa_scheduler(const numa_scheduler&) = delete;
+    numa_scheduler& operator=(const numa_scheduler&) = delete;
+
+    int num_nodes() const { return (int)node_ids.size(); }
+    int num_workers() const { return (int)queues.size(); }
+
+    // Queue fn on a worker of physical node `node`. Nodes the scheduler
+    // does not run on fall back to the submitting side's round-robin.
+    void submit_on(int node, task_type fn) {
+        int k = index_of(node);
+        if (k < 0) {
+            k = (int)(spill.fetch_add(1, std::memory_order_relaxed) % node_ids.size());
+        }
+        unsigned slot = next_worker[k]->fetch_add(1, std::memory_order_relaxed);
+        push(node_workers[k][slot % node_workers[k].size()], std::move(fn));
+    }
+
+    // Queue fn on the node that backs ptr. Pages that are not yet faulted
+    // in (or any lookup failure) are treated like an unknown node.
+    void submit_near(const void* ptr, task_type fn) {
+        int node = -1;
+        try {
+            node = get_numa_node_id(const_cast<void*>(ptr));
+        } catch (const std::runtime_error&) {
+            node = -1;
+        }
+        submit_on(node, std::move(fn));
+    }
+
+    // Block until every submitted task has run.
+    void wait() {
+        std::unique_lock<std::mutex> guard(done_lk);
+        done_cv.wait(guard, [this] { return outstanding.load(std::memory_order_acquire) == 0; });
+    }
+
+private:
+    struct worker_queue {
+        std::mutex lk;
+        std::deque<task_type> tasks;
+    };
+
+    std::vector<int> node_ids;                       // index -> physical node
+    std::vector<std::vector<int>> node_workers;      // index -> worker ids
+    std::vector<std::unique_ptr<std::atomic<unsigned>>> next_worker;
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<int> worker_node;
+    std::vector<int> worker_cpu;
+    std::vector<std::vector<int>> steal_order;       // per worker: victims, nearest first
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> spill{0};
+
+    std::atomic<long> queued{0};        // tasks sitting in some deque
+    std::atomic<long> outstanding{0};   // tasks submitted and not finished
+    std::mutex sleep_lk;
+    std::condition_variable sleep_cv;
+    bool stopping = false;
+    std::mutex done_lk;
+    std::condition_variable done_cv;
+
+    int index_of(int node) const {
+        for (int k = 0; k < (int)node_ids.size(); ++k) {
+            if (node_ids[k] == node) {
+                return k;
+            }
+        }
+        return -1;
+    }
+
+    void build_steal_order() {
+        int nnodes = (int)node_ids.size();
+        for (int w = 0; w < (int)queues.size(); ++w) {
+            int k = worker_node[w];
+            std::vector<int> order;
+            for (int peer : node_workers[k]) {
+                if (peer != w) {
+                    order.push_back(peer);
+                }
+            }
+            std::vector<int> remote;
+            for (int r = 0; r < nnodes; ++r) {
+                if (r != k) {
+                    remote.push_back(r);
+                }
+            }
+            std::stable_sort(remote.begin(), remote.end(), [&](int a, int b) {
+                return distance(k, a) < distance(k, b);
+            });
+            for (int r : remote) {
+                for (int peer : node_workers[r]) {
+                    order.push_back(peer);
+                }
+            }
+            steal_order.push_back(order);
+        }
+    }
+
+    int distance(int from, int to) const {
+        if (numa_available() == -1) {
+            return 0;
+        }
+        return numa_distance(node_ids[from], node_ids[to]);
+    }
+
+    void push(int w, task_type fn) {
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> guard(queues[w]->lk);
+            queues[w]->tasks.push_back(std::move(fn));
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        {
+            // Taking sleep_lk orders the increment before any sleeper's
+            // predicate check, so the wakeup below cannot be lost.
+            std::lock_guard<std::mutex> guard(sleep_lk);
+        }
+        sleep_cv.notify_all();
+    }
+
+    bool take(int w, task_type& out) {
+        {
+            worker_queue& own = *queues[w];
+            std::lock_guard<std::mutex> guard(own.lk);
+            if (!own.tasks.empty()) {
+                out = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (int victim : steal_order[w]) {
+            worker_queue& q = *queues[victim];
+            std::lock_guard<std::mutex> guard(q.lk);
+            if (!q.tasks.empty()) {
+                out = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(int w) {
+        if (worker_cpu[w] >= 0 && numa_available() != -1) {
+            numa_topology::pin_to_cpu(worker_cpu[w]);
+        }
+        while (true) {
+            task_type task;
+            if (take(w, task)) {
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                task();
+                if (outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> guard(done_lk);
+                    done_cv.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(sleep_lk);
+            sleep_cv.wait(guard, [this] {
+                return stopping || queued.load(std::memory_order_acquire) > 0;
+            });
+            if (stopping && queued.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,185 @@
+#pragma once
+#ifndef NUMASLAB_HPP
+#define NUMASLAB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+#include <numaif.h> //mbind
+#include <numa.h>
+#include <sys/mman.h>
+
+// Per-node size-class slab arena used by NumaAllocator.
+//
+// Memory is reserved from the kernel in CHUNK_SIZE chunks that are bound to
+// NodeID with mbind before they are first touched, then carved into fixed-size
+// slots. Every thread keeps its own free list per size class so the common
+// allocate/deallocate path takes no lock; threads only touch the per-node
+// pool (under its mutex) to refill or to hand back a surplus batch.
+// Chunks are never returned to the kernel.
+namespace numa_slab {
+
+constexpr std::size_t CHUNK_SIZE = 2 * 1024 * 1024;
+constexpr std::size_t MIN_SLOT = 16;
+constexpr std::size_t NUM_CLASSES = 8;          // 16, 32, ... 2048 bytes
+constexpr std::size_t MAX_SLOT = MIN_SLOT << (NUM_CLASSES - 1);
+constexpr std::size_t BATCH = 64;               // slots moved between a thread and its pool at once
+
+struct free_slot {
+    free_slot* next;
+};
+
+inline std::size_t size_class(std::size_t sz) {
+    std::size_t idx = 0;
+    std::size_t slot = MIN_SLOT;
+    while (slot < sz) {
+        slot <<= 1;
+        ++idx;
+    }
+    return idx;
+}
+
+inline constexpr std::size_t class_size(std::size_t idx) {
+    return MIN_SLOT << idx;
+}
+
+inline void* map_chunk_on_node(std::size_t len, int node) {
+    void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    struct bitmask* nodes = numa_allocate_nodemask();
+    numa_bitmask_setbit(nodes, node);
+    // Same behaviour as numa_alloc_onnode: if the policy cannot be applied
+    // (e.g. the node is offline) the chunk is still usable, just not bound.
+    mbind(p, len, MPOL_BIND, nodes->maskp, nodes->size + 1, 0);
+    numa_bitmask_free(nodes);
+    return p;
+}
+
+template <int NodeID>
+class arena {
+private:
+    struct pool {
+        std::mutex lk;
+        free_slot* head = nullptr;
+        char* bump = nullptr;
+        char* bump_end = nullptr;
+    };
+
+    struct thread_cache {
+        free_slot* head[NUM_CLASSES] = {};
+        std::size_t count[NUM_CLASSES] = {};
+
+        ~thread_cache() {
+            for (std::size_t i = 0; i < NUM_CLASSES; ++i) {
+                if (head[i] != nullptr) {
+                    release(i, head[i], count[i]);
+                }
+            }
+        }
+    };
+
+    static pool& pools(std::size_t idx) {
+        static pool p[NUM_CLASSES];
+        return p[idx];
+    }
+
+    static thread_cache& cache() {
+        thread_local thread_cache c;
+        return c;
+    }
+
+    // Move up to BATCH slots of class idx from the node pool into the caller's list.
+    static std::size_t refill(std::size_t idx, free_slot*& out) {
+        pool& p = pools(idx);
+        std::size_t slot = class_size(idx);
+        std::size_t n = 0;
+        std::lock_guard<std::mutex> guard(p.lk);
+        while (n < BATCH && p.head != nullptr) {
+            free_slot* s = p.head;
+            p.head = s->next;
+            s->next = out;
+            out = s;
+            ++n;
+        }
+        while (n < BATCH) {
+            if (p.bump == p.bump_end) {
+                p.bump = static_cast<char*>(map_chunk_on_node(CHUNK_SIZE, NodeID));
+                p.bump_end = p.bump + CHUNK_SIZE;
+            }
+            free_slot* s = reinterpret_cast<free_slot*>(p.bump);
+            p.bump += slot;
+            s->next = out;
+            out = s;
+            ++n;
+        }
+        return n;
+    }
+
+    // Hand a chain of n slots back to the node pool.
+    static void release(std::size_t idx, free_slot* first, std::size_t n) {
+        free_slot* last = first;
+        for (std::size_t i = 1; i < n; ++i) {
+            last = last->next;
+        }
+        pool& p = pools(idx);
+        std::lock_guard<std::mutex> guard(p.lk);
+        last->next = p.head;
+        p.head = first;
+    }
+
+public:
+    static void* allocate(std::size_t sz) {
+        if (sz > MAX_SLOT) {
+            void* p = numa_alloc_onnode(sz, NodeID);
+            if (p == nullptr) {
+                throw std::bad_alloc();
+            }
+            return p;
+        }
+        std::size_t idx = size_class(sz);
+        thread_cache& c = cache();
+        if (c.head[idx] == nullptr) {
+            c.count[idx] += refill(idx, c.head[idx]);
+        }
+        free_slot* s = c.head[idx];
+        c.head[idx] = s->next;
+        --c.count[idx];
+        return s;
+    }
+
+    static void deallocate(void* ptr, std::size_t sz) noexcept {
+        if (ptr == nullptr) {
+            return;
+        }
+        if (sz > MAX_SLOT) {
+            numa_free(ptr, sz);
+            return;
+        }
+        std::size_t idx = size_class(sz);
+        thread_cache& c = cache();
+        free_slot* s = static_cast<free_slot*>(ptr);
+        s->next = c.head[idx];
+        c.head[idx] = s;
+        if (++c.count[idx] >= 2 * BATCH) {
+            // Keep the thread's list bounded so slots freed by a consumer
+            // thread flow back to producers on the same node.
+            free_slot* first = c.head[idx];
+            free_slot* last = first;
+            for (std::size_t i = 1; i < BATCH; ++i) {
+                last = last->next;
+            }
+            c.head[idx] = last->next;
+            c.count[idx] -= BATCH;
+            last->next = nullptr;
+            release(idx, first, BATCH);
+        }
+    }
+};
+
+} // namespace numa_slab
+
+#endif
@@ -9,8 +9,81 @@
 #include <numa.h>
 #include <thread>
 #include <map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <cassert>
+#include <pthread.h>
+#include <sched.h>
 
-#define MAX_CPUS 80
+// Machine layout as reported by libnuma, read at run time so the same
+// binary works on 2-, 4- and 8-node machines.
+namespace numa_topology {
+
+// Number of CPUs the kernel was configured with; sizes every cpu_set_t.
+inline int num_cpus() {
+    static int n = numa_available() == -1 ? 1 : numa_num_configured_cpus();
+    return n;
+}
+
+// Nodes that have at least one CPU, in ascending order.
+inline std::vector<int> nodes() {
+    std::vector<int> out;
+    if (numa_available() == -1) {
+        out.push_back(0);
+        return out;
+    }
+    struct bitmask* mask = numa_allocate_cpumask();
+    for (int n = 0; n <= numa_max_node(); ++n) {
+        if (!numa_bitmask_isbitset(numa_all_nodes_ptr, n)) {
+            continue;
+        }
+        if (numa_node_to_cpus(n, mask) == 0 && numa_bitmask_weight(mask) > 0) {
+            out.push_back(n);
+        }
+    }
+    numa_bitmask_free(mask);
+    return out;
+}
+
+// CPUs of node, in ascending order.
+inline std::vector<int> cpus_of(int node) {
+    std::vector<int> out;
+    if (numa_available() == -1) {
+        for (int i = 0; i < (int)std::thread::hardware_concurrency(); ++i) {
+            out.push_back(i);
+        }
+        return out;
+    }
+    struct bitmask* mask = numa_allocate_cpumask();
+    if (numa_node_to_cpus(node, mask) != 0) {
+        numa_bitmask_free(mask);
+        throw std::runtime_error("Getting bitmask failed");
+    }
+    for (int i = 0; i < num_cpus(); ++i) {
+        if (numa_bitmask_isbitset(mask, (unsigned)i)) {
+            out.push_back(i);
+        }
+    }
+    numa_bitmask_free(mask);
+    return out;
+}
+
+// Bind the calling thread to a single CPU.
+inline void pin_to_cpu(int cpu) {
+    int ncpus = num_cpus();
+    cpu_set_t* set = CPU_ALLOC(ncpus);
+    CPU_ZERO_S(CPU_ALLOC_SIZE(ncpus), set);
+    CPU_SET_S(cpu, CPU_ALLOC_SIZE(ncpus), set);
+    int rc = pthread_setaffinity_np(pthread_self(), CPU_ALLOC_SIZE(ncpus), set);
+    CPU_FREE(set);
+    if (rc != 0) {
+        throw std::runtime_error("could not bind thread");
+    }
+}
+
+} // namespace numa_topology
 
 template <int NodeID>
 class thread_numa : public std::thread {
@@ -63,11 +136,12 @@ private:
         if (result != 0 ){
             throw std::runtime_error("Getting bitmask failed");
         }
-        cpu_set_t* cpuset = CPU_ALLOC(MAX_CPUS);
-        CPU_ZERO(cpuset);
-        for(int i =0 ; i < MAX_CPUS; ++i){
+        int ncpus = numa_topology::num_cpus();
+        cpu_set_t* cpuset = CPU_ALLOC(ncpus);
+        CPU_ZERO_S(CPU_ALLOC_SIZE(ncpus), cpuset);
+        for(int i =0 ; i < ncpus; ++i){
             if(numa_bitmask_isbitset(mask,(unsigned)i)){
-                CPU_SET(i, cpuset);
+                CPU_SET_S(i, CPU_ALLOC_SIZE(ncpus), cpuset);
              // std::cout<<Node_num<<"cpu"<<i<<std::endl;
             }
         }
@@ -88,7 +162,7 @@ private:
         }
         pthread_t pid= (pthread_t) tid->native_handle();
         // printf("it->second %p\n", it->second);
-        if(pthread_setaffinity_np(pid, CPU_ALLOC_SIZE(MAX_CPUS), it->second)){
+        if(pthread_setaffinity_np(pid, CPU_ALLOC_SIZE(numa_topology::num_cpus()), it->second)){
             throw std::runtime_error("could not bind thread");
         }
         //numa_run_on_node(Node_num);  // Pin thread to NUMA node
@@ -96,5 +170,119 @@ private:
 };
 
 
+// Fixed set of worker threads spread over NUMA nodes.
+//
+// The pool is built once from a list of nodes (index k of the list is the
+// "node index" handed to jobs, nodes[k] the physical node). Each node gets
+// threads_per_node workers; with pin set, worker j of node k is bound to the
+// j-th CPU of nodes[k] (wrapping if there are more workers than CPUs),
+// otherwise the scheduler places it. threads_per_node == 0 means one worker
+// per CPU of that node.
+//
+// run() hands the same job to every worker and returns when all of them
+// are done; workers stay alive between runs, so per-thread state (allocator
+// caches, reclamation records) carries over.
+class numa_thread_pool {
+public:
+    using job_type = std::function<void(int node, int index, int tid)>;
+
+    numa_thread_pool(const std::vector<int>& nodes, int threads_per_node = 0, bool pin = true)
+        : node_ids(nodes) {
+        int tid = 0;
+        for (int k = 0; k < (int)node_ids.size(); ++k) {
+            std::vector<int> cpus = numa_topology::cpus_of(node_ids[k]);
+            int count = threads_per_node > 0 ? threads_per_node : (int)cpus.size();
+            per_node.push_back(count);
+            for (int j = 0; j < count; ++j) {
+                int cpu = (pin && !cpus.empty()) ? cpus[j % cpus.size()] : -1;
+                workers.emplace_back(&numa_thread_pool::worker_loop, this, k, j, tid++, cpu);
+            }
+        }
+    }
+
+    // One pool over every node that has CPUs.
+    explicit numa_thread_pool(int threads_per_node = 0, bool pin = true)
+        : numa_thread_pool(numa_topology::nodes(), threads_per_node, pin) {}
+
+    ~numa_thread_pool() {
+        {
+            std::lock_guard<std::mutex> guard(lk);
+            stopping = true;
+        }
+        start_cv.notify_all();
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    numa_thread_pool(const numa_thread_pool&) = delete;
+    numa_thread_pool& operator=(const numa_thread_pool&) = delete;
+
+    int num_nodes() const { return (int)node_ids.size(); }
+    int physical_node(int node) const { return node_ids[node]; }
+    int workers_on(int node) const { return per_node[node]; }
+    int num_workers() const { return (int)workers.size(); }
+
+    // Run job(node, index, tid) on every worker and wait for all of them.
+    void run(job_type job) {
+        std::unique_lock<std::mutex> guard(lk);
+        current = std::move(job);
+        pending = (int)workers.size();
+        ++generation;
+        start_cv.notify_all();
+        done_cv.wait(guard, [this] { return pending == 0; });
+        current = nullptr;
+    }
+
+    // Run job(node) once per node, on that node's first worker.
+    void run_per_node(const std::function<void(int node)>& job) {
+        run([&job](int node, int index, int) {
+            if (index == 0) {
+                job(node);
+            }
+        });
+    }
+
+private:
+    std::vector<int> node_ids;
+    std::vector<int> per_node;
+    std::vector<std::thread> workers;
+
+    std::mutex lk;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    job_type current;
+    unsigned long generation = 0;
+    int pending = 0;
+    bool stopping = false;
+
+    void worker_loop(int node, int index, int tid, int cpu) {
+        if (cpu >= 0) {
+            numa_topology::pin_to_cpu(cpu);
+        }
+        unsigned long seen = 0;
+        while (true) {
+            job_type job;
+            {
+                std::unique_lock<std::mutex> guard(lk);
+                start_cv.wait(guard, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                job = current;
+            }
+            job(node, index, tid);
+            {
+                std::lock_guard<std::mutex> guard(lk);
+                if (--pending == 0) {
+                    done_cv.notify_one();
+                }
+            }
+        }
+    }
+};
+
+
 #endif
 
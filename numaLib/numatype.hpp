@@ -13,6 +13,10 @@
 #include <stdexcept>
 #include <iostream>
 #include <cassert>
+#include "numaslab.hpp"
+
+// Allocations are served from the per-node slab arena in numaslab.hpp.
+// Build with -DNUMA_ALLOC_DIRECT to map every object with numa_alloc_onnode instead.
 template <typename T, int NodeID>
 class NumaAllocator {
 public:
@@ -35,15 +39,23 @@ public:
 
     pointer allocate(size_type n) {
         //std::cout << "Allocated on numa node: " << NodeID <<std::endl;
+#ifdef NUMA_ALLOC_DIRECT
         void* p = numa_alloc_onnode(n * sizeof(T), NodeID);
         if (p == nullptr) {
             throw std::bad_alloc();
         }
+#else
+        void* p = numa_slab::arena<NodeID>::allocate(n * sizeof(T));
+#endif
         return static_cast<pointer>(p);
     }
 
     void deallocate(pointer p, size_type n) noexcept {
+#ifdef NUMA_ALLOC_DIRECT
         numa_free(p, n * sizeof(T));
+#else
+        numa_slab::arena<NodeID>::deallocate(p, n * sizeof(T));
+#endif
     }
 
     template <typename U, typename... Args>                                     //What is this??
@@ -87,6 +99,7 @@ class numa<T,NodeID, Alloc, typename std::enable_if<(std::is_fundamental<T>::val
 public:
 	T contents;
 	using allocator_type = Alloc<T,NodeID>;
+	using byte_allocator_type = Alloc<char,NodeID>;
 	
 	inline T load()
 	__attribute__((always_inline)){
@@ -118,15 +131,25 @@ public:
 	}
 	
     static void* operator new(std::size_t sz){
-		allocator_type alloc;
+		byte_allocator_type alloc;
         return alloc.allocate(sz);
     }
 
     static void* operator new[](std::size_t sz){
-		allocator_type alloc;
+		byte_allocator_type alloc;
         return alloc.allocate(sz);
     }
 
+    static void operator delete(void* ptr, std::size_t sz){
+		byte_allocator_type alloc;
+        alloc.deallocate(static_cast<char*>(ptr), sz);
+    }
+
+    static void operator delete[](void* ptr, std::size_t sz){
+		byte_allocator_type alloc;
+        alloc.deallocate(static_cast<char*>(ptr), sz);
+    }
+
     //overload = operator
     numa& operator=(const T& data){
         store(data);
@@ -138,10 +161,74 @@ public:
 template<typename T, int NodeID, template <typename, int> class Alloc>
 class numa<T,NodeID, Alloc, typename std::enable_if<!(std::is_fundamental<T>::value || std::is_pointer<T>::value)>::type>: public T{
 public:
+    using byte_allocator_type = Alloc<char,NodeID>;
+    using T::T;
+
     numa(){
         //std::cout<<"numa constructor called"<<std::endl;
         //assert(false && "This constructor should never get called");
     }    
+
+    static void* operator new(std::size_t sz){
+        byte_allocator_type alloc;
+        return alloc.allocate(sz);
+    }
+
+    static void* operator new[](std::size_t sz){
+        byte_allocator_type alloc;
+        return alloc.allocate(sz);
+    }
+
+    static void operator delete(void* ptr, std::size_t sz){
+        byte_allocator_type alloc;
+        alloc.deallocate(static_cast<char*>(ptr), sz);
+    }
+
+    static void operator delete[](void* ptr, std::size_t sz){
+        byte_allocator_type alloc;
+        alloc.deallocate(static_cast<char*>(ptr), sz);
+    }
+};
+
+// Typed handle to a numa<T,NodeID> object. The node is part of the handle's
+// type, so member calls through -> resolve against the numa<T,NodeID>
+// specialization at compile time instead of going through a T* obtained by
+// reinterpret_cast (and the virtual dispatch that cast requires).
+template<typename T, int NodeID>
+class numa_ref {
+public:
+    using element_type = numa<T,NodeID>;
+    static constexpr int node_id = NodeID;
+
+    numa_ref() : ptr(nullptr) {}
+    explicit numa_ref(element_type* p) : ptr(p) {}
+
+    template<typename... Args>
+    static numa_ref make(Args&&... args){
+        return numa_ref(new element_type(std::forward<Args>(args)...));
+    }
+
+    void destroy(){
+        delete ptr;
+        ptr = nullptr;
+    }
+
+    inline element_type* operator->() const
+    __attribute__((always_inline)){
+        return ptr;
+    }
+
+    inline element_type& operator*() const
+    __attribute__((always_inline)){
+        return *ptr;
+    }
+
+    inline element_type* get() const { return ptr; }
+    explicit operator bool() const { return ptr != nullptr; }
+
+private:
+    element_type* ptr;
 };
 
+
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+ * Input for --infer-placement. worker() runs on node 0, so both news it
+ * reaches are candidates: Stack has a virtual destructor and becomes
+ * numa<Stack,0>, StackNode has none and is left alone ("non-virtual
+ * destructor"), since Stack::pop deletes it through a plain StackNode*.
+ *
+ * The program pushes and pops through the placed Stack and deletes it
+ * through a Stack*; built with -fsanitize=address, before and after the
+ * rewrite, it must exit 0 with no free of a pointer malloc did not return.
+ */
+
+#include <iostream>
+#include "numathreads.hpp"
+
+class StackNode
+{
+public:
+    StackNode(int data, StackNode* next) : data(data), next(next) {}
+    int data;
+    StackNode* next;
+};
+
+class Stack
+{
+public:
+    Stack() : top(nullptr), size(0) {}
+    virtual ~Stack()
+    {
+        while(top != nullptr){
+            pop();
+        }
+    }
+    void push(int data)
+    {
+        top = new StackNode(data, top);
+        size++;
+    }
+    int pop()
+    {
+        StackNode* node = top;
+        int data = node->data;
+        top = node->next;
+        size--;
+        delete node;
+        return data;
+    }
+    bool empty() const { return top == nullptr; }
+
+private:
+    StackNode* top;
+    int size;
+};
+
+void worker(int count, bool* ok)
+{
+    Stack* stack = new Stack();
+    for(int i = 0; i < count; i++){
+        stack->push(i);
+    }
+    //half popped here, the rest by the destructor
+    bool lifo = true;
+    for(int i = count - 1; i >= count / 2; i--){
+        lifo = lifo && stack->pop() == i;
+    }
+    delete stack;
+    *ok = lifo;
+}
+
+int main()
+{
+    bool ok = false;
+    thread_numa<0> thread(worker, 1000, &ok);
+    thread.join();
+    std::cout << (ok ? "placed stack ok" : "placed stack popped out of order") << "\n";
+    return ok ? 0 : 1;
+}
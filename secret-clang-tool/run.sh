@@ -2,7 +2,7 @@
 
 # Check if an argument is provided
 if [ -z "$1" ]; then
-  echo "Usage: $0 <DS|dummy|STExprs|Exprs>"
+  echo "Usage: $0 <DS|dummy|STExprs|Exprs|Placement>"
   exit 1
 fi
 
@@ -49,8 +49,16 @@ case "$1" in
     ./build/bin/clang-tool  --secret input/SecretExprs/Examples/main.cpp input/SecretExprs/Examples/TestSuite.cpp -- -I input/SecretExprs/include/ -I../secretLib/ -I/usr/local/lib/clang/20/include/
     ;;
 
+  Placement)
+    echo "Running Placement"
+    # the input must run clean under ASan both before and after the rewrite
+    ./build/bin/clang-tool  --numa --infer-placement input/Placement/placed_stack.cpp -- -I../numaLib/ -I/usr/local/lib/clang/20/include/
+
+    clang++ -std=c++20 -g -fsanitize=address -pthread -I../numaLib/ output/Placement/placed_stack.cpp -lnuma -o output/Placement/placed_stack && ./output/Placement/placed_stack
+    ;;
+
   *)
-    echo "Invalid argument. Usage: $0 <DS|dummy|Exprs|STExprs>"
+    echo "Invalid argument. Usage: $0 <DS|dummy|Exprs|STExprs|Placement>"
     exit 1
     ;;
 esac
\ No newline at end of file
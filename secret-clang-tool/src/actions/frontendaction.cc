@@ -16,7 +16,7 @@ std::unique_ptr<clang::ASTConsumer> SecretRecursiveFrontendAction::CreateASTCons
     llvm::errs() << "** Creating AST consumer for: " << inFile << "\n";
     TheRewriter.setSourceMgr(compiler.getSourceManager(), compiler.getLangOpts());
     llvm::outs() << "file hash value: " << TheRewriter.getSourceMgr().getMainFileID().getHashValue() << "\n";
-    return std::make_unique<RecursiveSecretConsumer>(TheRewriter, &compiler.getASTContext());
+    return std::make_unique<RecursiveSecretConsumer>(TheRewriter, &compiler.getASTContext(), inFile);
 
 }
 
@@ -1,10 +1,15 @@
 #include "consumer.h"
 #include "../transformer/RecursiveSecretTyper.h"
+#include "../transformer/NumaPlacement.h"
+#include "rewritestore.h"
+#include "../utils/transformcache.h"
 #include <fstream>
 #include <string>
 #include "llvm/Support/WithColor.h"
 #include <cstdlib>
-RecursiveSecretConsumer::RecursiveSecretConsumer(clang::Rewriter& TheReWriter, clang::ASTContext* context)
+#include <filesystem>
+RecursiveSecretConsumer::RecursiveSecretConsumer(clang::Rewriter& TheReWriter, clang::ASTContext* context, llvm::StringRef mainFile)
+    : mainFile(mainFile.str())
 {
     rewriter = TheReWriter;
 }
@@ -31,21 +36,47 @@ void RecursiveSecretConsumer::WriteOutput(clang::SourceManager &SM){
 
                 std::string fileName = (std::string)it->first.getName();
                 std::string outputFileName = fileName.replace(fileName.find("input"), 5, "output");
-                std::string directory = outputFileName.substr(0, outputFileName.find_last_of("/"));
-                std::string command = "mkdir -p " + directory;  
-                system(command.c_str());
-
-                std::error_code EC;
-                llvm::raw_fd_ostream OutFile((llvm::StringRef)outputFileName, EC, llvm::sys::fs::OF_Text);
-                if(EC){
-                    llvm::errs() << "Error opening output file: " << EC.message() << "\n";
-                    return;
-                }
-                buffer->write(OutFile);
+
+                //other translation units may rewrite the same header; the store
+                //keeps one copy and main writes it after the last TU
+                std::string contents;
+                llvm::raw_string_ostream OS(contents);
+                buffer->write(OS);
+                OS.flush();
+                StoreOutput(outputFileName, std::move(contents));
             }
         }
     }
 }
+
+void RecursiveSecretConsumer::StoreOutput(const std::string &outputFileName, std::string contents){
+    if(TRANSFORM_CACHE.enabled()){
+        cacheOutputs.emplace_back(outputFileName, contents);
+    }
+    REWRITE_STORE.add(outputFileName, std::move(contents), mainFile);
+}
+
+/*
+ * Write each specialization's out-of-line member definitions beside the
+ * rewritten file its class is defined in; the typer already included the
+ * header after the specialization. Every TU that specializes the class
+ * produces the same contents, so the rewrite store keeps one copy.
+ */
+void RecursiveSecretConsumer::WriteGeneratedHeaders(const std::vector<RecursiveSecretTyper::GeneratedHeader> &headers){
+    for(const auto &header : headers){
+        std::string fileName = header.definingFile;
+        size_t input = fileName.find("input");
+        if(input == std::string::npos){
+            llvm::errs() << fileName << " is not under an input directory, not writing " << header.name << "\n";
+            continue;
+        }
+        std::filesystem::path outputFile = fileName.replace(input, 5, "output");
+        //only the file name, so TUs that reached the class by different paths agree
+        StoreOutput((outputFile.parent_path() / header.name).string(),
+                    "// Generated from " + outputFile.filename().string() + ": members of a secret<> specialization\n"
+                    "#pragma once\n" + header.definitions);
+    }
+}
 void RecursiveSecretConsumer::includeSecretHeader(clang::ASTContext &context){
     for(auto it = rewriter.getSourceMgr().fileinfo_begin(); it != rewriter.getSourceMgr().fileinfo_end(); it++){
         const FileEntry *FE = it->first;
@@ -83,6 +114,11 @@ void RecursiveSecretConsumer::includeSecretHeader(clang::ASTContext &context){
 
 
 void RecursiveSecretConsumer::HandleTranslationUnit(clang::ASTContext &context){
+    if(INFER_PLACEMENT){
+        NumaPlacement numaPlacement(context, rewriter);
+        numaPlacement.start();
+        numaPlacement.print(llvm::outs());
+    }
     llvm::outs() <<"Calling template arg transformer\n";
     RecursiveSecretTyper recursiveSecretTyper(context, rewriter);
     // // //fntransformer.start();
@@ -94,7 +130,30 @@ void RecursiveSecretConsumer::HandleTranslationUnit(clang::ASTContext &context){
     }
 
     includeSecretHeader(context);       //turn this on to include numaheaders
+    WriteGeneratedHeaders(recursiveSecretTyper.getGeneratedHeaders());
     WriteOutput(rewriter.getSourceMgr());
+    RecordInCache(rewriter.getSourceMgr());
+}
+
+void RecursiveSecretConsumer::RecordInCache(clang::SourceManager &SM){
+    if(!TRANSFORM_CACHE.enabled()){
+        return;
+    }
+    //every user file this TU read; system headers are assumed not to change
+    std::vector<std::string> dependencies;
+    for(auto it = SM.fileinfo_begin(); it != SM.fileinfo_end(); it++){
+        const FileEntry *FE = it->first;
+        if(FE){
+            FileID FID = SM.getOrCreateFileID(it->first, SrcMgr::CharacteristicKind::C_User);
+            if(SM.isInSystemHeader(SM.getLocForStartOfFile(FID))){
+                continue;
+            }
+            llvm::SmallString<256> path(it->first.getName());
+            SM.getFileManager().makeAbsolutePath(path);
+            dependencies.push_back(path.str().str());
+        }
+    }
+    TRANSFORM_CACHE.record(mainFile, dependencies, cacheOutputs);
 }
     
 
@@ -4,6 +4,10 @@
 #include <clang/AST/ASTContext.h>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/Rewrite/Core/Rewriter.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../transformer/RecursiveSecretTyper.h"
 
 namespace clang
 {
@@ -17,11 +21,18 @@ class RecursiveSecretConsumer : public clang::ASTConsumer
         clang::Rewriter rewriter;
         //The container for the file IDs in the rewriters source manager
         std::vector<llvm::StringRef> rewriterFileNames;
+        //The translation unit being rewritten, as given to the frontend action
+        std::string mainFile;
+        //What WriteOutput produced, for TRANSFORM_CACHE
+        std::vector<std::pair<std::string, std::string>> cacheOutputs;
         
     public:
-        explicit RecursiveSecretConsumer(clang::Rewriter& TheReWriter, clang::ASTContext* context);
+        explicit RecursiveSecretConsumer(clang::Rewriter& TheReWriter, clang::ASTContext* context, llvm::StringRef mainFile);
         void includeSecretHeader(clang::ASTContext &context);
         void WriteOutput(clang::SourceManager &SM);
+        void StoreOutput(const std::string &outputFileName, std::string contents);
+        void WriteGeneratedHeaders(const std::vector<RecursiveSecretTyper::GeneratedHeader> &headers);
+        void RecordInCache(clang::SourceManager &SM);
         virtual void HandleTranslationUnit( clang::ASTContext &context) override;
 };
 // class PPConsumer : public clang::ASTConsumer 
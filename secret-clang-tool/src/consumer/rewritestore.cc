@@ -0,0 +1,67 @@
+#include "rewritestore.h"
+#include <filesystem>
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/FileSystem.h"
+
+RewriteStore REWRITE_STORE;
+
+void RewriteStore::setSources(const std::vector<std::string> &sources)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    sourceOrder.clear();
+    for(size_t i = 0; i < sources.size(); i++)
+    {
+        sourceOrder[std::filesystem::absolute(sources[i]).lexically_normal().string()] = i;
+    }
+}
+
+void RewriteStore::add(const std::string &outputFile, std::string contents, const std::string &mainFile)
+{
+    std::string key = std::filesystem::absolute(mainFile).lexically_normal().string();
+    std::lock_guard<std::mutex> guard(lock);
+    auto order = sourceOrder.find(key);
+    size_t position = (order == sourceOrder.end()) ? 0 : order->second;
+
+    auto it = files.find(outputFile);
+    if(it == files.end())
+    {
+        files.emplace(outputFile, Entry{std::move(contents), position, mainFile});
+        return;
+    }
+    if(it->second.contents == contents)
+    {
+        return;
+    }
+    conflicts.push_back(outputFile + " (" + it->second.producer + " vs " + mainFile + ")");
+    if(position >= it->second.order)
+    {
+        it->second = Entry{std::move(contents), position, mainFile};
+    }
+}
+
+bool RewriteStore::flush()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    bool ok = true;
+    for(auto &file : files)
+    {
+        std::error_code EC;
+        std::filesystem::create_directories(std::filesystem::path(file.first).parent_path(), EC);
+        llvm::raw_fd_ostream OutFile(file.first, EC, llvm::sys::fs::OF_Text);
+        if(EC)
+        {
+            llvm::errs() << "Error opening output file " << file.first << ": " << EC.message() << "\n";
+            ok = false;
+            continue;
+        }
+        OutFile << file.second.contents;
+    }
+    for(auto &conflict : conflicts)
+    {
+        llvm::errs() << "Translation units rewrote a shared file differently, kept the later one: " << conflict << "\n";
+    }
+    llvm::outs() << "Wrote " << files.size() << " rewritten files\n";
+    files.clear();
+    conflicts.clear();
+    return ok;
+}
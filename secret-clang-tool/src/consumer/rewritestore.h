@@ -0,0 +1,45 @@
+#ifndef REWRITESTORE_HPP
+#define REWRITESTORE_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Rewritten files of all translation units, written out once the last one
+ * is done. Translation units run on a worker pool and share headers, so
+ * the same output file is usually produced by several of them: identical
+ * copies are kept once, and if two differ the one from the translation
+ * unit listed last wins, which is what the serial run (each TU overwriting
+ * the file in turn) ended up with.
+ */
+class RewriteStore
+{
+    private:
+        struct Entry
+        {
+            std::string contents;
+            size_t order;           //position of the producing TU in the source list
+            std::string producer;
+        };
+
+        std::mutex lock;
+        std::map<std::string, size_t> sourceOrder;
+        std::map<std::string, Entry> files;
+        std::vector<std::string> conflicts;
+
+    public:
+        //Source list of the run, in command-line order
+        void setSources(const std::vector<std::string> &sources);
+
+        //Record outputFile as rewritten by translation unit mainFile. Safe to call from any worker.
+        void add(const std::string &outputFile, std::string contents, const std::string &mainFile);
+
+        //Write every stored file, creating directories as needed. Returns false if any write failed.
+        bool flush();
+};
+
+extern RewriteStore REWRITE_STORE;
+
+#endif
@@ -4,6 +4,8 @@
 #include <iostream>
 #include "actions/frontendaction.h"
 #include "actions/cast_frontendaction.h"
+#include "transformer/RecursiveSecretTyper.h"
+#include "transformer/NumaPlacement.h"
 #include "utils/utils.h"
 #include "clang/Tooling/Tooling.h"
 #include "clang/Frontend/CompilerInstance.h"
@@ -33,6 +35,13 @@
 #include "clang/Basic/SourceManager.h"
 
 #include <filesystem>
+#include <mutex>
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "consumer/rewritestore.h"
+#include "utils/transformcache.h"
+#include "llvm/Support/FileSystem.h"
 using namespace std;
 using namespace llvm;
 using namespace clang;
@@ -64,67 +73,67 @@ void registerBenchmarks(){
     for(auto &benchmark : benchmarks){
         //import the benchmarkst to the input directory
         std::string baseDir = (std::string)HOME + "/SecretTyping/secret-clang-tool/";
-        if (fs::exists(baseDir+"input/"+benchmark) && fs::is_directory(baseDir+"input/"+benchmark)) {
-            std::string command = "rm -rf " + baseDir+"input/"+benchmark;
-            system(command.c_str());
-            command = "cp -r " +  (std::string)HOME + "/SecretTyping/" + benchmark + " " + baseDir+"input/";
-            system(command.c_str());
-        } else {
-            std::string command = "cp -r " +  (std::string)HOME + "/SecretTyping/" + benchmark + " " + baseDir+"input/";
-            system(command.c_str());
+        std::string source = (std::string)HOME + "/SecretTyping/" + benchmark;
+        std::error_code EC;
+        fs::remove_all(baseDir+"input/"+benchmark, EC);
+        fs::create_directories(baseDir+"input/", EC);
+        fs::copy(source, baseDir+"input/"+benchmark, fs::copy_options::recursive | fs::copy_options::overwrite_existing, EC);
+        if(EC){
+            llvm::errs() << "Could not import " << source << ": " << EC.message() << "\n";
         }
 
-        if (fs::exists(baseDir+"output/"+benchmark) && fs::is_directory(baseDir+"output/"+benchmark)) {
-            std::string command = "rm -rf " + baseDir +"output/"+ benchmark+"/*";
-            system(command.c_str());
+        if (fs::is_directory(baseDir+"output/"+benchmark)) {
+            utils::clearDirectory(baseDir+"output/"+benchmark);
         }
-        if (fs::exists(baseDir+"output2/"+benchmark) && fs::is_directory(baseDir+"output2/"+benchmark)) {
-            std::string command = "rm -rf " + baseDir +"output2/"+ benchmark+"/*";
-            system(command.c_str());
-        }
-    
-    
-        
-        //remove everything from output
-        if(utils::fileExists(outputDirectory) == true){   
-            std::string command = "rm -rf " + outputDirectory + "/*";
-            system(command.c_str());
-        }
-        else{
-            std::string command = "mkdir -p " + outputDirectory;
-            system(command.c_str());
+        if (fs::is_directory(baseDir+"output2/"+benchmark)) {
+            utils::clearDirectory(baseDir+"output2/"+benchmark);
         }
 
-        std::string command = "cp -r " + inputDirectory + "/* " + outputDirectory;
-        system(command.c_str());
+        //remove everything from output
+        utils::clearDirectory(outputDirectory);
+        utils::copyDirectoryContents(inputDirectory, outputDirectory);
     }
 }
 
 void copyOuputToOutput2(){
-    for(auto &benchmark : benchmarks)
+  //For each benchmark, copy the contents from the output directory to the output2 directory
+  for(auto &benchmark : benchmarks)
   {
-      std::string directory = "output2/" + benchmark;
-      if(utils::fileExists(directory) == true)
-      {
-          //remove everything in the directory
-          std::string command = "rm -rf " + directory + "/*";
-          system(command.c_str());
-      }
-      else
-      {
-          std::string command = "mkdir -p " + directory;
-          system(command.c_str());
-      }
+      utils::clearDirectory("output2/" + benchmark);
+      utils::copyDirectoryContents("output/" + benchmark, "output2/" + benchmark);
   }
+}
 
-  //For each benchmark, copy the contents from the input directory to the output directory
-  for(auto &benchmark : benchmarks)
-  {
-      std::string inputDirectory = "output/" + benchmark;
-      std::string outputDirectory = "output2/" + benchmark;
-      std::string command = "cp -r " + inputDirectory + "/* " + outputDirectory;
-      system(command.c_str());
+// Bump when a change to the tool should invalidate cached output even if
+// the binary's size and mtime somehow stayed the same.
+static const char *CACHE_FORMAT = "secret-clang-tool cache 1";
+
+// Cache version: the format above plus the executable's size and mtime, so
+// rebuilding the tool invalidates everything it emitted before.
+std::string toolVersion(const char *argv0) {
+  static int StaticSymbol;
+  std::string Exe = llvm::sys::fs::getMainExecutable(argv0, &StaticSymbol);
+  llvm::sys::fs::file_status Status;
+  std::string Version = CACHE_FORMAT;
+  if (!llvm::sys::fs::status(Exe, Status)) {
+    Version += " " + std::to_string(Status.getSize()) + " " +
+               std::to_string(Status.getLastModificationTime().time_since_epoch().count());
   }
+  return Version;
+}
+
+// Everything besides file contents that changes what a TU is rewritten to.
+std::string flagsKey(const std::vector<CompileCommand> &Commands) {
+  std::string Key = VIRTUAL_DISPATCH ? "virtual-dispatch" : "";
+  Key += INLINE_SPECIALIZATIONS ? " inline-specializations" : "";
+  Key += INFER_PLACEMENT ? " infer-placement" : "";
+  for (const CompileCommand &Command : Commands) {
+    Key += '\n' + Command.Directory;
+    for (const std::string &Arg : Command.CommandLine) {
+      Key += '\0' + Arg;
+    }
+  }
+  return TransformCache::hashContents(Key);
 }
 
 void print(const std::vector<CompileCommand> &Commands) {
@@ -155,6 +164,44 @@ int main(int argc, const char **argv) {
         cl::cat(ToolCategory)
     );
 
+    static cl::opt<unsigned> Jobs(
+        "j",
+        cl::desc("Translation units to process in parallel (default: one per hardware thread)"),
+        cl::init(0),
+        cl::cat(ToolCategory)
+    );
+
+    static cl::opt<std::string> CacheDir(
+        "cache-dir",
+        cl::desc("Directory of the cache of rewritten output; translation units whose files, flags and tool are unchanged are not transformed again"),
+        cl::init(".secret-cache"),
+        cl::cat(ToolCategory)
+    );
+
+    static cl::opt<bool> NoCache(
+        "no-cache",
+        cl::desc("Transform every translation unit and leave the cache untouched"),
+        cl::cat(ToolCategory)
+    );
+
+    static cl::opt<bool> VirtualDispatch(
+        "virtual-dispatch",
+        cl::desc("Mark members of specialized classes virtual (needed when specializations are used through reinterpret_cast'ed base pointers)"),
+        cl::cat(ToolCategory)
+    );
+
+    static cl::opt<bool> InlineSpecializations(
+        "inline-specializations",
+        cl::desc("Write member bodies inside each specialization instead of into the translation unit's generated header"),
+        cl::cat(ToolCategory)
+    );
+
+    static cl::opt<bool> InferPlacement(
+        "infer-placement",
+        cl::desc("Rewrite new T to new numa<T,N> where only thread_numa<N> threads reach it, and print the placement map"),
+        cl::cat(ToolCategory)
+    );
+
 
     auto ExpectedParser = CommonOptionsParser::create(argc, argv, ToolCategory);
 
@@ -163,6 +210,9 @@ int main(int argc, const char **argv) {
         return 1;
     }
     CommonOptionsParser& OptionsParser = ExpectedParser.get();
+    VIRTUAL_DISPATCH = VirtualDispatch;
+    INLINE_SPECIALIZATIONS = InlineSpecializations;
+    INFER_PLACEMENT = InferPlacement;
 
     std::unique_ptr<FrontendActionFactory> Factory;
 
@@ -176,7 +226,59 @@ int main(int argc, const char **argv) {
         llvm::errs() << "Please specify either --count-functions or --count-classes.\n";
         return 1;
     }
-    ClangTool Tool(OptionsParser.getCompilations(), OptionsParser.getSourcePathList());
-    return Tool.run(Factory.get());
-    //return 0;
+    if (!Factory) {
+        llvm::errs() << "The cast frontend action is disabled in this build.\n";
+        return 1;
+    }
+
+    // One ClangTool per translation unit on a worker pool, like clang's
+    // AllTUsToolExecutor. Each gets its own physical file system so working
+    // directory changes stay per thread; the rewritten files go to
+    // REWRITE_STORE and are written once all units are done.
+    const std::vector<std::string> &Sources = OptionsParser.getSourcePathList();
+    REWRITE_STORE.setSources(Sources);
+    if (!NoCache) {
+        TRANSFORM_CACHE.load(CacheDir, toolVersion(argv[0]));
+    }
+    if (Jobs != 1) {
+        // the typer logs heavily; unbuffered keeps concurrent writers from sharing the buffer
+        llvm::outs().SetUnbuffered();
+    }
+
+    std::mutex FailedLock;
+    std::vector<std::string> Failed;
+    {
+        llvm::DefaultThreadPool Pool(llvm::hardware_concurrency(Jobs));
+        for (const std::string &Source : Sources) {
+            TransformCache::Outputs Cached;
+            if (TRANSFORM_CACHE.enabled() &&
+                TRANSFORM_CACHE.lookup(Source, flagsKey(OptionsParser.getCompilations().getCompileCommands(Source)), Cached)) {
+                llvm::outs() << "Unchanged, reusing cached output of " << Source << "\n";
+                for (auto &Output : Cached) {
+                    REWRITE_STORE.add(Output.first, std::move(Output.second), Source);
+                }
+                continue;
+            }
+            Pool.async([&, Source] {
+                ClangTool Tool(OptionsParser.getCompilations(), {Source},
+                               std::make_shared<PCHContainerOperations>(),
+                               llvm::vfs::createPhysicalFileSystem());
+                if (Tool.run(Factory.get()) != 0) {
+                    std::lock_guard<std::mutex> Guard(FailedLock);
+                    Failed.push_back(Source);
+                }
+            });
+        }
+        Pool.wait();
+    }
+
+    bool Written = REWRITE_STORE.flush();
+    // a failed TU may have recorded partial output; only keep a clean run
+    if (Failed.empty() && TRANSFORM_CACHE.enabled()) {
+        TRANSFORM_CACHE.save();
+    }
+    for (const std::string &Source : Failed) {
+        llvm::errs() << "Failed to process " << Source << "\n";
+    }
+    return (Failed.empty() && Written) ? 0 : 1;
 }
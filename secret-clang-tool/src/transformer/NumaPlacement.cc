@@ -0,0 +1,220 @@
+#include "NumaPlacement.h"
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/ASTMatchers/ASTMatchers.h>
+#include <clang/Rewrite/Core/Rewriter.h>
+#include "clang/Analysis/CallGraph.h"
+#include "clang/Lex/Lexer.h"
+#include <string>
+
+// Set by --infer-placement. Off by default: the rewrite changes where
+// objects live, which the programmer otherwise decides in source.
+bool INFER_PLACEMENT = false;
+
+NumaPlacement::NumaPlacement(clang::ASTContext &context, clang::Rewriter &rewriter)
+    : Transformer(context, rewriter)
+{}
+
+void NumaPlacement::start()
+{
+    using namespace clang::ast_matchers;
+    //all entries have to be known before any new is placed, hence two passes
+    MatchFinder entryFinder;
+    entryFinder.addMatcher(cxxConstructExpr(unless(isExpansionInSystemHeader())).bind("threadConstruct"), this);
+    entryFinder.matchAST(context);
+    if(entries.empty()){
+        return;
+    }
+    propagate();
+
+    MatchFinder newFinder;
+    newFinder.addMatcher(cxxNewExpr(unless(isExpansionInSystemHeader()),
+                                    hasAncestor(functionDecl().bind("function"))).bind("newExpr"), this);
+    newFinder.matchAST(context);
+
+    for(FileID FID : rewrittenFiles){
+        rewriter.InsertTextBefore(rewriter.getSourceMgr().getLocForStartOfFile(FID), "#include \"numatype.hpp\"\n");
+    }
+}
+
+void NumaPlacement::run(const clang::ast_matchers::MatchFinder::MatchResult &result){
+    if(const auto *construct = result.Nodes.getNodeAs<CXXConstructExpr>("threadConstruct")){
+        addEntry(construct);
+        return;
+    }
+    const auto *newExpr = result.Nodes.getNodeAs<CXXNewExpr>("newExpr");
+    const auto *function = result.Nodes.getNodeAs<FunctionDecl>("function");
+    //hasAncestor can match once per enclosing function; the nearest one comes first
+    if(newExpr && function && seenNews.insert(newExpr).second){
+        place(newExpr, function, *result.SourceManager);
+    }
+}
+
+void NumaPlacement::addEntry(const clang::CXXConstructExpr* construct){
+    const auto *thread = dyn_cast<ClassTemplateSpecializationDecl>(construct->getConstructor()->getParent());
+    if(!thread || thread->getSpecializedTemplate()->getNameAsString() != "thread_numa"){
+        return;
+    }
+    const TemplateArgumentList &args = thread->getTemplateArgs();
+    if(args.size() == 0 || args[0].getKind() != TemplateArgument::Integral){
+        return;
+    }
+    //moving a thread_numa around starts nothing
+    if(construct->getNumArgs() == 0 || construct->getConstructor()->isCopyOrMoveConstructor()){
+        return;
+    }
+
+    const Expr *func = construct->getArg(0)->IgnoreParenImpCasts();
+    if(const auto *addressOf = dyn_cast<UnaryOperator>(func)){
+        if(addressOf->getOpcode() == UO_AddrOf){
+            func = addressOf->getSubExpr()->IgnoreParenImpCasts();
+        }
+    }
+    const FunctionDecl *entry = nullptr;
+    if(const auto *ref = dyn_cast<DeclRefExpr>(func)){
+        entry = dyn_cast<FunctionDecl>(ref->getDecl());
+    }
+    else if(const auto *lambda = dyn_cast<LambdaExpr>(func)){
+        entry = lambda->getCallOperator();
+    }
+    int64_t node = args[0].getAsIntegral().getExtValue();
+    if(!entry){
+        llvm::outs() << "thread_numa<" << node << "> at "
+                     << construct->getBeginLoc().printToString(context.getSourceManager())
+                     << " does not start a named function or lambda, its allocations are not placed\n";
+        return;
+    }
+    entries[entry->getCanonicalDecl()].insert(node);
+}
+
+/*
+ * Walk the call graph from every entry and tag each function it reaches
+ * with the entry's nodes. Calls through function pointers are not in the
+ * graph, so news behind them stay unplaced rather than placed wrongly.
+ */
+void NumaPlacement::propagate(){
+    clang::CallGraph graph;
+    graph.addToCallGraph(context.getTranslationUnitDecl());
+
+    for(auto &entry : entries){
+        llvm::DenseSet<const Decl*> visited;
+        std::vector<const Decl*> worklist;
+        visited.insert(entry.first);
+        worklist.push_back(entry.first);
+        while(!worklist.empty()){
+            const Decl *function = worklist.back();
+            worklist.pop_back();
+            reachingNodes[function].insert(entry.second.begin(), entry.second.end());
+
+            CallGraphNode *node = graph.getNode(function);
+            if(!node){
+                continue;
+            }
+            for(const CallGraphNode::CallRecord &call : *node){
+                const Decl *callee = call.Callee->getDecl();
+                if(callee && visited.insert(callee).second){
+                    worklist.push_back(callee);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * A placed object is still freed wherever the program deletes a T*. That
+ * only reaches numa<T,N>'s operator delete when T's destructor is virtual;
+ * otherwise the slab pointer would be handed to the global delete.
+ */
+static bool hasVirtualDestructor(const CXXRecordDecl *record){
+    if(!record || !record->hasDefinition()){
+        return false;
+    }
+    if(const CXXDestructorDecl *destructor = record->getDestructor()){
+        return destructor->isVirtual();
+    }
+    //an implicit destructor that was never declared is virtual if a base's is
+    for(const CXXBaseSpecifier &base : record->bases()){
+        if(hasVirtualDestructor(base.getType()->getAsCXXRecordDecl())){
+            return true;
+        }
+    }
+    return false;
+}
+
+void NumaPlacement::place(const clang::CXXNewExpr* newExpr, const clang::FunctionDecl* function, clang::SourceManager &SM){
+    const CXXRecordDecl *record = newExpr->getAllocatedType()->getAsCXXRecordDecl();
+    //numa<T,N> derives from T, so only class types can be placed this way
+    if(!record || !record->getIdentifier() || function->isDependentContext()){
+        return;
+    }
+    if(const auto *spec = dyn_cast<ClassTemplateSpecializationDecl>(record)){
+        if(spec->getSpecializedTemplate()->getNameAsString() == "numa"){
+            return;
+        }
+    }
+
+    TypeSourceInfo *typeInfo = newExpr->getAllocatedTypeSourceInfo();
+    SourceRange typeRange = typeInfo ? typeInfo->getTypeLoc().getSourceRange() : SourceRange();
+
+    Placement placement;
+    placement.location = newExpr->getBeginLoc().printToString(SM);
+    placement.type = newExpr->getAllocatedType().getAsString();
+    placement.function = function->getQualifiedNameAsString();
+    auto reached = reachingNodes.find(function->getCanonicalDecl());
+    if(reached != reachingNodes.end()){
+        placement.nodes = reached->second;
+    }
+
+    if(placement.nodes.size() != 1){
+        placement.outcome = placement.nodes.empty() ? "not reached from a thread_numa" : "reached from several nodes";
+    }
+    else if(newExpr->isArray() || newExpr->getNumPlacementArgs() > 0){
+        placement.outcome = "array or placement new";
+    }
+    else if(newExpr->getInitializationStyle() == CXXNewInitializationStyle::Braces){
+        //numa<T,N> is not an aggregate, so T{...} may not mean the same thing
+        placement.outcome = "brace initializer";
+    }
+    else if(record->isEffectivelyFinal()){
+        placement.outcome = "final class";
+    }
+    else if(!hasVirtualDestructor(record)){
+        placement.outcome = "non-virtual destructor";
+    }
+    else if(function->isTemplateInstantiation()){
+        //the source is shared by every instantiation
+        placement.outcome = "inside a template instantiation";
+    }
+    else if(typeRange.isInvalid() || typeRange.getBegin().isMacroID() || typeRange.getEnd().isMacroID()){
+        placement.outcome = "type spelled in a macro";
+    }
+    else{
+        int64_t node = *placement.nodes.begin();
+        llvm::StringRef typeText = Lexer::getSourceText(CharSourceRange::getTokenRange(typeRange), SM, context.getLangOpts());
+        rewriter.ReplaceText(CharSourceRange::getTokenRange(typeRange), "numa<" + typeText.str() + "," + std::to_string(node) + ">");
+        rewrittenFiles.insert(SM.getFileID(typeRange.getBegin()));
+        placement.outcome = "numa<" + typeText.str() + "," + std::to_string(node) + ">";
+    }
+    placements.push_back(placement);
+}
+
+void NumaPlacement::print(clang::raw_ostream &stream){
+    //one write, so parallel translation units do not interleave their maps
+    std::string map;
+    llvm::raw_string_ostream OS(map);
+    OS << "Placement map (" << entries.size() << " thread_numa entries, " << placements.size() << " allocations):\n";
+    for(const Placement &placement : placements){
+        OS << "  " << placement.location << ": new " << placement.type << " in " << placement.function << " -> " << placement.outcome;
+        if(placement.nodes.size() > 1){
+            OS << " {";
+            for(auto node = placement.nodes.begin(); node != placement.nodes.end(); ++node){
+                OS << (node == placement.nodes.begin() ? "" : ", ") << *node;
+            }
+            OS << "}";
+        }
+        OS << "\n";
+    }
+    OS.flush();
+    stream << map;
+}
@@ -0,0 +1,68 @@
+#ifndef NUMAPLACEMENT_HPP
+#define NUMAPLACEMENT_HPP
+
+#include "transformer.h"
+
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/ExprCXX.h>
+#include <clang/ASTMatchers/ASTMatchers.h>
+#include <clang/Rewrite/Core/Rewriter.h>
+#include "clang/AST/ASTContext.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace clang;
+
+extern bool INFER_PLACEMENT;
+
+/*
+ * Infers the NodeID of untyped allocations from the thread that runs them.
+ * Every thread_numa<N>(entry, ...) construction makes entry a root for node
+ * N; the call graph of the translation unit carries the node to every
+ * function reachable from it. A `new T` of a class type inside a function
+ * reached from exactly one node is rewritten to `new numa<T,N>`, which is
+ * still convertible to T*. Only classes with a virtual destructor are
+ * placed, so a plain `delete p` on the T* still frees through numa<T,N>.
+ * News reached from several nodes, or from none, are left alone and listed
+ * in the placement map print() writes.
+ */
+class NumaPlacement : public Transformer
+{
+    private:
+        struct Placement
+        {
+            std::string location;
+            std::string type;
+            std::string function;
+            std::set<int64_t> nodes;
+            std::string outcome;        //the numa<T,N> it became, or why it was left alone
+        };
+
+        //thread_numa entry functions by canonical decl, and the nodes they are started on
+        llvm::DenseMap<const clang::FunctionDecl*, std::set<int64_t>> entries;
+        //nodes each function is reachable from, filled by propagate()
+        llvm::DenseMap<const clang::Decl*, std::set<int64_t>> reachingNodes;
+        llvm::DenseSet<const clang::CXXNewExpr*> seenNews;
+        std::set<clang::FileID> rewrittenFiles;
+        std::vector<Placement> placements;
+
+        void addEntry(const clang::CXXConstructExpr* construct);
+        void propagate();
+        void place(const clang::CXXNewExpr* newExpr, const clang::FunctionDecl* function, clang::SourceManager &SM);
+
+    public:
+        explicit NumaPlacement(clang::ASTContext &context, clang::Rewriter &rewriter);
+
+        virtual void start() override;
+        virtual void print(clang::raw_ostream &stream) override;
+        virtual void run(const clang::ast_matchers::MatchFinder::MatchResult &result);
+};
+
+#endif
@@ -21,8 +21,20 @@
 
 std::string SECRET_TYPE = "secret";
 int run_once = 0;
+// Specializations are emitted non-virtual so callers holding the specialized
+// type get statically dispatched, inlinable members. Set by --virtual-dispatch
+// for code that still calls through reinterpret_cast'ed base pointers.
+bool VIRTUAL_DISPATCH = false;
+// Specializations declare their members in class; the definitions go to a
+// generated header per class, secret_<Class>_generated.hpp beside the file
+// the class is defined in, included right after the specialization (see
+// getGeneratedHeaders). Every translation unit specializing the class emits
+// the same header, which the rewrite store keeps once. Set by
+// --inline-specializations to write the bodies in class as before.
+bool INLINE_SPECIALIZATIONS = false;
 std::string allocator_funcs = R"(using allocator_type = NumaAllocator<T,NodeID>;// Alloc<T, NodeID>;
 using pointer_alloc_type =NumaAllocator<T*,NodeID>; //Alloc<T*, NodeID>;
+using byte_allocator_type = NumaAllocator<char,NodeID>; //backed by the per-node slab arena
 public:
        
     numa(T t) : T(t) {}
@@ -35,16 +47,28 @@ public:
 
     static void* operator new(std::size_t count)
     {
-        allocator_type alloc;
+        byte_allocator_type alloc;
         return alloc.allocate(count);
     }
  
     static void* operator new[](std::size_t count)
     {
         //todo: disable placement new for numa.
-        allocator_type alloc;
+        byte_allocator_type alloc;
         return alloc.allocate(count);
     }
+
+    static void operator delete(void* ptr, std::size_t count)
+    {
+        byte_allocator_type alloc;
+        alloc.deallocate(static_cast<char*>(ptr), count);
+    }
+
+    static void operator delete[](void* ptr, std::size_t count)
+    {
+        byte_allocator_type alloc;
+        alloc.deallocate(static_cast<char*>(ptr), count);
+    }
 	
     numa& operator[](std::size_t index) {
         static_assert(std::is_pointer<T>::value,"[] operator is only valid for pointer types");
@@ -151,12 +175,12 @@ void RecursiveSecretTyper::start()
 
 
 
-std::string RecursiveSecretTyper::getSecretConstructorSignature(clang::CXXConstructorDecl* constructor) {
+std::string RecursiveSecretTyper::getSecretConstructorSignature(clang::CXXConstructorDecl* constructor, const std::string& scope) {
     std::string ConstructorName = constructor->getParent()->getNameAsString();    
 
     FunctionDecl* constructorDefinition= constructor->getDefinition();
     // Initialize an empty string to build the signature
-    std::string ConstructorSignature = "secret (";
+    std::string ConstructorSignature = scope + "secret (";
     
     // Get the number of parameters
     unsigned ParamCount = constructorDefinition->getNumParams();
@@ -203,6 +227,18 @@ std::string utils::getMemberInitString(std::map<std::string, std::string>& initM
     return result;
 }
 
+std::string utils::getFieldInitString(FieldDecl* field) {
+    // Keep default member initializers (e.g. Node *tail = nullptr;) so
+    // constructors that rely on them still see the same starting state.
+    if (!field->hasInClassInitializer() || field->getInClassInitializer() == nullptr) {
+        return "";
+    }
+    std::string InitValue;
+    llvm::raw_string_ostream OS(InitValue);
+    field->getInClassInitializer()->printPretty(OS, nullptr, field->getASTContext().getPrintingPolicy());
+    return " = " + OS.str();
+}
+
 std::string utils::getDelegatingInitString(CXXConstructorDecl* constructor) {
      for (const auto *Init : constructor->inits()) {
         if (Init->isDelegatingInitializer()) {
@@ -235,7 +271,7 @@ std::string utils::getDelegatingInitString(CXXConstructorDecl* constructor) {
     return " ";
 }
 
-std::string RecursiveSecretTyper::getSecretMethodSignature(CXXMethodDecl* method){
+std::string RecursiveSecretTyper::getSecretMethodSignature(CXXMethodDecl* method, const std::string& scope){
     FunctionDecl *methodDefinition = method->getDefinition();
     std::string ReturnTypeStr;
     llvm::raw_string_ostream ReturnTypeOS(ReturnTypeStr);
@@ -264,10 +300,39 @@ std::string RecursiveSecretTyper::getSecretMethodSignature(CXXMethodDecl* method
     ParamsStr += ")";
 
     // Build full method signature
-    std::string MethodSignature = "virtual "+ReturnTypeOS.str() + " " + MethodName + ParamsStr;
+    //virtual only goes on the in-class declaration
+    std::string MethodSignature = (VIRTUAL_DISPATCH && scope.empty() ? "virtual " : "")+ReturnTypeOS.str() + " " + scope + MethodName + ParamsStr;
     return MethodSignature;
 }
 
+std::string RecursiveSecretTyper::getSecretScope(const clang::CXXRecordDecl* secretClass){
+    return "secret<" + secretClass->getNameAsString() + ">::";
+}
+
+/*
+ * Emit one member of a specialization. tail is what follows the signature:
+ * the constructor initializers, if any, and the body. Inline, the whole
+ * member goes into the class; otherwise the class gets the declaration and
+ * the definition is appended to classDefinitions.
+ */
+void RecursiveSecretTyper::emitMember(const std::string& declaration, const std::string& definition, const std::string& tail, clang::SourceLocation& rewriteLocation){
+    if(INLINE_SPECIALIZATIONS){
+        rewriter.InsertTextAfter(rewriteLocation, declaration);
+        rewriter.InsertTextAfter(rewriteLocation, tail);
+        return;
+    }
+    rewriter.InsertTextAfter(rewriteLocation, declaration + ";\n");
+    //inline: several translation units may define the same class's members
+    classDefinitions += "inline " + definition + tail;
+    if(tail.empty() || tail.back() != '\n'){
+        classDefinitions += "\n";
+    }
+}
+
+std::vector<RecursiveSecretTyper::GeneratedHeader> RecursiveSecretTyper::getGeneratedHeaders(){
+    return generatedHeaders;
+}
+
 
 void RecursiveSecretTyper::extractNumaDecls(clang::Stmt* fnBody, ASTContext *Context){
     //fnBody->dump();
@@ -336,6 +401,11 @@ void RecursiveSecretTyper::extractNumaDecls(clang::Stmt* fnBody, ASTContext *Con
 
 
 void RecursiveSecretTyper::addAllSpecializations(clang::ASTContext* Context){
+    //the user-written specializations do not change while we run; one scan is enough
+    if(existingSpecializationsScanned){
+        return;
+    }
+    existingSpecializationsScanned = true;
     clang::TranslationUnitDecl *TU = Context->getTranslationUnitDecl();
     for (const auto *Decl : TU->decls()) {
         if (const auto *SpecDecl = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>(Decl)) {
@@ -348,7 +418,7 @@ void RecursiveSecretTyper::addAllSpecializations(clang::ASTContext* Context){
                             if (CXXRecordDecl *CXXRD = dyn_cast<CXXRecordDecl>(RT->getDecl())) {
                                 llvm::outs() << "Found a secret specialization of type " << CXXRD->getNameAsString() << "\n";
                                 //if CXXRD is not in specializedSecretClasses, add it
-                                if(std::find(specializedSecretClasses.begin(), specializedSecretClasses.end(), CXXRD) == specializedSecretClasses.end()){
+                                if(specializedSecretSet.insert(CXXRD->getCanonicalDecl()).second){
                                     //add it to the specializedSecretClasses
                                     specializedSecretClasses.push_back(CXXRD);}
 
@@ -362,16 +432,33 @@ void RecursiveSecretTyper::addAllSpecializations(clang::ASTContext* Context){
 }
 
 bool RecursiveSecretTyper::NumaSpeclExists(const clang::CXXRecordDecl* FirstTempArg, int64_t SecondTempArg){
-     std::pair<const clang::CXXRecordDecl*,int64_t> searchPair = {FirstTempArg, SecondTempArg};
+    return specializedClassSet.contains({FirstTempArg->getCanonicalDecl(), SecondTempArg});
+}
 
-    // Search for the pair in the vector
-    auto it = std::find(specializedClasses.begin(), specializedClasses.end(), searchPair);
+bool RecursiveSecretTyper::isSpecialized(const clang::CXXRecordDecl* secretClass){
+    return specializedSecretSet.contains(secretClass->getCanonicalDecl());
+}
 
-    if (it != specializedClasses.end()) {
-        return true;
-    } else {
-        return false;
+/*
+ * Mark secretClass as specialized and queue it; specializeClass() emits the
+ * queue. Field types found while emitting a class are queued here instead
+ * of being specialized recursively, so deep or cyclic type graphs cost one
+ * visit per class and no stack depth.
+ */
+void RecursiveSecretTyper::requestSpecialization(const clang::CXXRecordDecl* secretClass){
+    if(!secretClass){
+        return;
+    }
+    if(!specializedSecretSet.insert(secretClass->getCanonicalDecl()).second){
+        return;
+    }
+    const clang::CXXRecordDecl* definition = secretClass->getDefinition();
+    if(!definition){
+        llvm::outs() << secretClass->getNameAsString() << " has no definition to specialize\n";
+        return;
     }
+    specializedSecretClasses.push_back(definition);
+    pendingSpecializations.push_back(definition);
 }
 
 void RecursiveSecretTyper::makeVirtual(const CXXRecordDecl* classDecl){
@@ -422,13 +509,19 @@ void RecursiveSecretTyper::specializeClass(clang::ASTContext* Context, const cla
     // for(auto it = specializedClasses.begin(); it != specializedClasses.end(); ++it){
     //     llvm::outs() << it->first->getNameAsString() << " " << it->second << "\n";
     // }
-    constructSpecialization(Context, secretClass);
+    requestSpecialization(secretClass);
+    while(!pendingSpecializations.empty()){
+        const clang::CXXRecordDecl* next = pendingSpecializations.front();
+        pendingSpecializations.pop_front();
+        constructSpecialization(Context, next);
+    }
 
 }
 
 void RecursiveSecretTyper::constructSpecialization(clang::ASTContext* Context,const clang::CXXRecordDecl* secretClass){
-    specializedSecretClasses.push_back(secretClass);
-    makeVirtual(secretClass);
+    if(VIRTUAL_DISPATCH){
+        makeVirtual(secretClass);
+    }
     
     rewriteLocation = secretClass->getEndLoc();
     SourceLocation semiLoc = Lexer::findLocationAfterToken(
@@ -440,11 +533,13 @@ void RecursiveSecretTyper::constructSpecialization(clang::ASTContext* Context,co
     std::vector<CXXMethodDecl*> publicMethods;
     std::vector<CXXMethodDecl*> privateMethods;
 
+    // The specialization has no subclasses, so protected members go out with
+    // the private ones instead of being dropped.
     for(auto field : secretClass->fields()){
         if(field->getAccess() == AS_public){
             publicFields.push_back(field);
         }
-        else if(field->getAccess() == AS_private){
+        else{
             privateFields.push_back(field);
         }
     }
@@ -453,7 +548,7 @@ void RecursiveSecretTyper::constructSpecialization(clang::ASTContext* Context,co
         if(method->getAccess() == AS_public){
             publicMethods.push_back(method);
         }
-        else if(method->getAccess() == AS_private){
+        else{
             privateMethods.push_back(method);
         }
     }
@@ -462,9 +557,20 @@ void RecursiveSecretTyper::constructSpecialization(clang::ASTContext* Context,co
                                             "class secret<"+secretClass->getNameAsString()+">{\n");
     rewriter.InsertTextAfter(semiLoc, utils::getSecretAllocatorCode(secretClass->getNameAsString()));
 
+    classDefinitions.clear();
     secretPublicMembers(Context, semiLoc, publicFields, publicMethods);
     secretPrivateMembers(Context, semiLoc, privateFields, privateMethods);
     rewriter.InsertTextAfter(semiLoc, "};\n");  
+    //no out-of-line members, no header
+    if(!classDefinitions.empty()){
+        SourceManager &SM = rewriter.getSourceMgr();
+        GeneratedHeader header;
+        header.definingFile = SM.getFilename(SM.getExpansionLoc(semiLoc)).str();
+        header.name = "secret_" + secretClass->getNameAsString() + "_generated.hpp";
+        header.definitions = classDefinitions;
+        rewriter.InsertTextAfter(semiLoc, "#include \"" + header.name + "\"\n");
+        generatedHeaders.push_back(header);
+    }
 
     fileIDs.push_back(rewriter.getSourceMgr().getFileID(rewriteLocation));
 
@@ -479,35 +585,29 @@ void RecursiveSecretTyper::secretPublicMembers(clang::ASTContext* Context, clang
         /*Case where the field is a built in type but not a pointer */
         if(fields->getType()->isBuiltinType()){
          
-            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType().getAsString()+"> "+ fields->getNameAsString()+";\n" );
+            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType().getAsString()+"> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
         }
 
         /*Case where the field is a built in type and a pointer*/
         else if(fields->getType()->isPointerType() && fields->getType()->getPointeeType()->isBuiltinType()){
                
-                rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType()->getPointeeType().getAsString() +"> "+ fields->getNameAsString()+";\n" );
+                rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType()->getPointeeType().getAsString() +"*> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
             
         }
 
         /*Case where the field is not a built in type but is a pointer*/
         else if(fields->getType()->isPointerType() && !fields->getType()->getPointeeType()->isBuiltinType()){
             
-            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType()->getPointeeType().getAsString() +"*> "+ fields->getNameAsString()+";\n" );
+            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType()->getPointeeType().getAsString() +"*> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
         
             //makeVirtual(fields->getType()->getPointeeCXXRecordDecl());
-            //check if field type is in specialized classes
-            if(std::find(specializedSecretClasses.begin(), specializedSecretClasses.end(), fields->getType()->getPointeeCXXRecordDecl()) == specializedSecretClasses.end()){
-                //start specializing it 
-                constructSpecialization(Context, fields->getType()->getPointeeType()->getAsCXXRecordDecl());
-            }
+            //queue the field type unless it is already specialized
+            requestSpecialization(fields->getType()->getPointeeCXXRecordDecl());
         }
         /*Case where the field is not a built in type and not a pointer*/
         else if (!fields->getType()->isBuiltinType() && !fields->getType()->isPointerType()){        
-            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType().getAsString() +"> "+ fields->getNameAsString()+";\n" );
-            if(std::find(specializedSecretClasses.begin(), specializedSecretClasses.end(), fields->getType()->getAsCXXRecordDecl()) == specializedSecretClasses.end()){
-                //start specializing it 
-                constructSpecialization(Context, fields->getType()->getAsCXXRecordDecl());
-            }
+            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType().getAsString() +"> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
+            requestSpecialization(fields->getType()->getAsCXXRecordDecl());
         }
         else{
         }
@@ -542,34 +642,28 @@ void RecursiveSecretTyper::secretPrivateMembers(clang::ASTContext* Context, clan
     for(auto fields :privateFields){
         /*Case where the field is a built in type but not a pointer */
         if(fields->getType()->isBuiltinType()){
-            rewriter.InsertTextAfter(rewriteLocation, "numa<"+fields->getType().getAsString()+"> "+ fields->getNameAsString()+";\n" );
+            rewriter.InsertTextAfter(rewriteLocation, "numa<"+fields->getType().getAsString()+"> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
         }
 
         /*Case where the field is a built in type and a pointer*/
         else if(fields->getType()->isPointerType() && fields->getType()->getPointeeType()->isBuiltinType()){
-                rewriter.InsertTextAfter(rewriteLocation, "numa<"+fields->getType()->getPointeeType().getAsString() +"*> "+ fields->getNameAsString()+";\n" );
+                rewriter.InsertTextAfter(rewriteLocation, "numa<"+fields->getType()->getPointeeType().getAsString() +"*> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
             
         }
 
         /*Case where the field is not a built in type but is a pointer*/
         else if(fields->getType()->isPointerType() && !fields->getType()->getPointeeType()->isBuiltinType()){
            
-            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType()->getPointeeType().getAsString() +"*> "+ fields->getNameAsString()+";\n" );
+            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType()->getPointeeType().getAsString() +"*> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
         
             //makeVirtual(fields->getType()->getPointeeCXXRecordDecl());
-            //check if field type is in specialized classes
-            if(std::find(specializedSecretClasses.begin(), specializedSecretClasses.end(), fields->getType()->getPointeeCXXRecordDecl()) == specializedSecretClasses.end()){
-                //start specializing it 
-                constructSpecialization(Context, fields->getType()->getPointeeType()->getAsCXXRecordDecl());
-            }
+            //queue the field type unless it is already specialized
+            requestSpecialization(fields->getType()->getPointeeCXXRecordDecl());
         }
         /*Case where the field is not a built in type and not a pointer*/
         else if (!fields->getType()->isBuiltinType() && !fields->getType()->isPointerType()){
-            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType().getAsString() +"> "+ fields->getNameAsString()+";\n" );
-            if(std::find(specializedSecretClasses.begin(), specializedSecretClasses.end(), fields->getType()->getAsCXXRecordDecl()) == specializedSecretClasses.end()){
-                //start specializing it 
-                constructSpecialization(Context, fields->getType()->getAsCXXRecordDecl());
-            }
+            rewriter.InsertTextAfter(rewriteLocation, "secret<"+fields->getType().getAsString() +"> "+ fields->getNameAsString()+utils::getFieldInitString(fields)+";\n" );
+            requestSpecialization(fields->getType()->getAsCXXRecordDecl());
         }
         else{
         }
@@ -635,25 +729,28 @@ void RecursiveSecretTyper::secretConstructors(clang::CXXConstructorDecl* constru
             }
         }
     }
+    //initializers belong to the definition, wherever it ends up
+    std::string secretConstructorTail;
     if (isMemberInit){
-        secretConstructorSignatrue += initMembersString;
+        secretConstructorTail += initMembersString;
     }
     if(isDelegatingInit){
-        secretConstructorSignatrue += utils::getDelegatingInitString(constructor);
+        secretConstructorTail += utils::getDelegatingInitString(constructor);
     }
-    rewriter.InsertTextAfter(rewriteLocation, secretConstructorSignatrue);
-    // rewriter.InsertTextAfter(rewriteLocation, "{");
     if (constructor->hasBody()) { // Check if the method has a body
         const Stmt *ConstructorBody = constructor->getBody(); // Get the body
         std::string BodyStr;
         llvm::raw_string_ostream OS(BodyStr);
         // Pretty print the body
         ConstructorBody->printPretty(OS, nullptr, constructor->getASTContext().getPrintingPolicy());
-        rewriter.InsertTextAfter(rewriteLocation, OS.str());
+        secretConstructorTail += OS.str();
     }
     else{
-        rewriter.InsertTextAfter(rewriteLocation, "{}\n");
+        secretConstructorTail += "{}\n";
     }
+    emitMember(secretConstructorSignatrue,
+               getSecretConstructorSignature(constructor, getSecretScope(constructor->getParent())),
+               secretConstructorTail, rewriteLocation);
 }
    
 
@@ -661,74 +758,51 @@ void RecursiveSecretTyper::secretConstructors(clang::CXXConstructorDecl* constru
 
 
 void RecursiveSecretTyper::secretDestructors(clang::CXXDestructorDecl* destructor, clang::SourceLocation& rewriteLocation){
-    //if the constructor has no parameters, we just close the constructor
-
-    rewriter.InsertTextAfter(rewriteLocation, "virtual ~secret(");
-    if (destructor->parameters().size() == 0){
-        rewriter.InsertTextAfter(rewriteLocation, ")\n");
-    
-        if(destructor->hasBody()){
-
-            destructor->dump();
-            SourceRange BodyRange = destructor->getBody()->getSourceRange();
-            const SourceManager &SM = destructor->getASTContext().getSourceManager();
-            llvm::StringRef BodyText = Lexer::getSourceText(CharSourceRange::getTokenRange(BodyRange), SM, destructor->getASTContext().getLangOpts());
-            //Pass it through a function that searches for 'new' in the body and replaces 'new''s return type with numa<T,N>
-            //std::string numaedBody = replaceNewType(std::string(BodyText), N);
-            //Then we replace the body 
-            rewriter.InsertTextAfter(rewriteLocation, BodyText);
-            rewriter.InsertTextAfter(rewriteLocation, "\n");
+    std::string params = "(";
+    for(auto param : destructor->getDefinition()->parameters())
+    {
+        params += param->getType().getAsString() + " " + param->getNameAsString();
+        //avoid the last comma
+        if(param != destructor->getDefinition()->parameters().back())
+        {
+            params += ", ";
         }
     }
-    //rewrite the paramenters of the constructor
+    params += ")";
+
+    std::string body = "\n";
+    if(destructor->hasBody()){
+        SourceRange BodyRange = destructor->getBody()->getSourceRange();
+        const SourceManager &SM = destructor->getASTContext().getSourceManager();
+        llvm::StringRef BodyText = Lexer::getSourceText(CharSourceRange::getTokenRange(BodyRange), SM, destructor->getASTContext().getLangOpts());
+        body += BodyText.str() + "\n";
+    }
     else{
-        for(auto param : destructor->getDefinition()->parameters())
-        {
-            //get the implementation of the constructor
-            
-            rewriter.InsertTextAfter(rewriteLocation, param->getType().getAsString() + " " + param->getNameAsString());
-            //avoid the last comma
-            if(param != destructor->getDefinition()->parameters().back())
-            {
-                rewriter.InsertTextAfter(rewriteLocation, ", ");
-            }
-        }
-        //after rewriting the parameters, we close the constructor
-        rewriter.InsertTextAfter(rewriteLocation, ")");
-
-        //if the constructor has a body, before we rewrite the body, we have to replace the new expression with new numa<T,N>
-        if(destructor->hasBody()){
-            //destructor->dump();
-            SourceRange BodyRange = destructor->getBody()->getSourceRange();
-            const SourceManager &SM = destructor->getASTContext().getSourceManager();
-            llvm::StringRef BodyText = Lexer::getSourceText(CharSourceRange::getTokenRange(BodyRange), SM, destructor->getASTContext().getLangOpts());
-            //Pass it through a function that searches for 'new' in the body and replaces 'new''s return type with numa<T,N>
-            //std::string numaedBody = replaceNewType(std::string(BodyText), N);
-            //Then we replace the body 
-            rewriter.InsertTextAfter(rewriteLocation, BodyText);
-            rewriter.InsertTextAfter(rewriteLocation, "\n");
-        }
-    } 
+        body += "{}\n";
+    }
+    emitMember((VIRTUAL_DISPATCH ? "virtual ~secret" : "~secret") + params,
+               getSecretScope(destructor->getParent()) + "~secret" + params,
+               body, rewriteLocation);
 }
 
 
 
 void RecursiveSecretTyper::secretMethods(clang::CXXMethodDecl* method, clang::SourceLocation& rewriteLocation){
-    std::string methodSignature = getSecretMethodSignature(method);
-
-    rewriter.InsertTextAfter(rewriteLocation, methodSignature);
+    std::string body;
     if (method->hasBody()) { // Check if the method has a body
         const Stmt *MethodBody = method->getBody(); // Get the body
-        std::string BodyStr;
-        llvm::raw_string_ostream OS(BodyStr);
+        llvm::raw_string_ostream OS(body);
         // Pretty print the body
         MethodBody->printPretty(OS, nullptr, method->getASTContext().getPrintingPolicy());
-        // llvm::outs() << "Method Body:\n" << OS.str() << "\n";
-        rewriter.InsertTextAfter(rewriteLocation, OS.str());
+        OS.flush();
+        // llvm::outs() << "Method Body:\n" << body << "\n";
     }
     else{
-        rewriter.InsertTextAfter(rewriteLocation, "{}\n");
+        body = "{}\n";
     }
+    emitMember(getSecretMethodSignature(method),
+               getSecretMethodSignature(method, getSecretScope(method->getParent())),
+               body, rewriteLocation);
 }
 
 
@@ -779,7 +853,7 @@ void RecursiveSecretTyper::run(const clang::ast_matchers::MatchFinder::MatchResu
                         QualType argType = Arg.getAsType();
                         CXXRecordDecl* secretClass = argType->getAsCXXRecordDecl();
                         llvm::outs() << "Gonna check if  " << secretClass->getNameAsString() << " is in specialized classes\n";
-                        if(std::find(specializedSecretClasses.begin(), specializedSecretClasses.end(), secretClass) == specializedSecretClasses.end()){
+                        if(secretClass && !isSpecialized(secretClass)){
                             //start specializing it
                             llvm::outs() <<secretClass->getNameAsString() << " is not in specializedSecretClasses\n"; 
                             specializeClass(result.Context, secretClass);
@@ -20,6 +20,8 @@
 
 #include <set>
 #include <map>
+#include <deque>
+#include "llvm/ADT/DenseSet.h"
 
 // namespace clang
 // {
@@ -28,14 +30,37 @@
 //     class Rewriter;
 // }
 using namespace clang;
+
+extern bool VIRTUAL_DISPATCH;
+extern bool INLINE_SPECIALIZATIONS;
+
 class RecursiveSecretTyper : public Transformer
 {
     private:
         std::vector<const clang::CXXNewExpr*> numaDeclTable;
         std::vector<std::pair<const clang::CXXRecordDecl*, int64_t>> specializedClasses;
         std::vector<const clang::CXXRecordDecl*> specializedSecretClasses;
+        //Hashed indexes of the two lists above, keyed by canonical decl (and node)
+        llvm::DenseSet<std::pair<const clang::CXXRecordDecl*, int64_t>> specializedClassSet;
+        llvm::DenseSet<const clang::CXXRecordDecl*> specializedSecretSet;
+        //Classes queued by requestSpecialization() and not emitted yet
+        std::deque<const clang::CXXRecordDecl*> pendingSpecializations;
+        bool existingSpecializationsScanned = false;
         clang::SourceLocation rewriteLocation;
         std::vector<clang::FileID> fileIDs;
+    public:
+        //Out-of-line member definitions of one specialization and where they go
+        struct GeneratedHeader
+        {
+            std::string definingFile;   //file the class is defined in; the header goes beside its output
+            std::string name;           //secret_<Class>_generated.hpp, included after the specialization
+            std::string definitions;
+        };
+
+    private:
+        std::vector<GeneratedHeader> generatedHeaders;
+        //Definitions of the specialization being emitted, filled by emitMember()
+        std::string classDefinitions;
         
     public:
         
@@ -52,6 +77,8 @@ class RecursiveSecretTyper : public Transformer
         }
         void extractNumaDecls(clang::Stmt *stmt, ASTContext *Context);
         bool NumaSpeclExists(const clang::CXXRecordDecl* FirstTemplateArg, int64_t SecondTemplateArg);
+        bool isSpecialized(const clang::CXXRecordDecl* secretClass);
+        void requestSpecialization(const clang::CXXRecordDecl* secretClass);
         void makeVirtual(const clang::CXXRecordDecl *classDecl);
 
         void specializeClass(clang::ASTContext* Context, const clang::CXXRecordDecl* secretClass);
@@ -61,12 +88,15 @@ class RecursiveSecretTyper : public Transformer
         void secretPrivateMembers(clang::ASTContext* Context, clang::SourceLocation& rewriteLocation,std::vector<clang::FieldDecl*> privateFields, std::vector<clang::CXXMethodDecl*> privateMethods);
 
         void secretConstructors(clang::CXXConstructorDecl* Ctor, clang::SourceLocation& rewriteLocation);
-        std::string getSecretConstructorSignature(clang::CXXConstructorDecl* Ctor);
+        std::string getSecretConstructorSignature(clang::CXXConstructorDecl* Ctor, const std::string& scope = "");
        
         void secretDestructors(clang::CXXDestructorDecl* Dtor, clang::SourceLocation& rewriteLocation);
         //TODO: Refactor numaDestructors according to numaConstructors
         void secretMethods(clang::CXXMethodDecl* method, clang::SourceLocation& rewriteLocation);
-        std::string getSecretMethodSignature(clang::CXXMethodDecl* method);
+        std::string getSecretMethodSignature(clang::CXXMethodDecl* method, const std::string& scope = "");
+        std::string getSecretScope(const clang::CXXRecordDecl* secretClass);
+        void emitMember(const std::string& declaration, const std::string& definition, const std::string& tail, clang::SourceLocation& rewriteLocation);
+        std::vector<GeneratedHeader> getGeneratedHeaders();
     
         
 };
@@ -0,0 +1,203 @@
+#include "transformcache.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include "llvm/Support/Format.h"
+
+TransformCache TRANSFORM_CACHE;
+
+std::string TransformCache::normalize(const std::string &path)
+{
+    return std::filesystem::absolute(path).lexically_normal().string();
+}
+
+std::string TransformCache::hashContents(const std::string &contents)
+{
+    std::string hash;
+    llvm::raw_string_ostream OS(hash);
+    OS << llvm::format_hex_no_prefix(llvm::xxHash64(contents), 16);
+    return OS.str();
+}
+
+std::string TransformCache::hashFile(const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = fileHashes.find(path);
+        if(it != fileHashes.end())
+        {
+            return it->second;
+        }
+    }
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    std::string hash = buffer ? hashContents((*buffer)->getBuffer().str()) : "";
+    std::lock_guard<std::mutex> guard(lock);
+    fileHashes[path] = hash;
+    return hash;
+}
+
+void TransformCache::load(const std::string &dir, const std::string &toolVersion)
+{
+    directory = dir;
+    version = toolVersion;
+    units = Json::Value(Json::objectValue);
+
+    std::ifstream in(dir + "/index.json");
+    if(!in.good())
+    {
+        return;
+    }
+    Json::Value index;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    if(!Json::parseFromStream(builder, in, &index, &errors))
+    {
+        llvm::errs() << "Ignoring unreadable cache index " << dir << "/index.json: " << errors << "\n";
+        return;
+    }
+    if(index["version"].asString() != version)
+    {
+        llvm::outs() << "Tool changed since the cache was written, transforming everything\n";
+        return;
+    }
+    units = index["units"];
+}
+
+bool TransformCache::readBlob(const std::string &hash, std::string &contents)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(directory + "/blobs/" + hash);
+    if(!buffer)
+    {
+        return false;
+    }
+    contents = (*buffer)->getBuffer().str();
+    return hashContents(contents) == hash;
+}
+
+bool TransformCache::lookup(const std::string &mainFile, const std::string &flagsKey, Outputs &outputs)
+{
+    std::string key = normalize(mainFile);
+    Json::Value unit;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        pendingFlags[key] = flagsKey;
+        if(!units.isMember(key))
+        {
+            return false;
+        }
+        unit = units[key];
+    }
+    if(unit["flags"].asString() != flagsKey)
+    {
+        return false;
+    }
+    const Json::Value &dependencies = unit["dependencies"];
+    for(const std::string &path : dependencies.getMemberNames())
+    {
+        if(hashFile(path) != dependencies[path].asString())
+        {
+            return false;
+        }
+    }
+
+    outputs.clear();
+    const Json::Value &files = unit["outputs"];
+    for(const std::string &path : files.getMemberNames())
+    {
+        std::string contents;
+        if(!readBlob(files[path].asString(), contents))
+        {
+            return false;
+        }
+        outputs.emplace_back(path, std::move(contents));
+    }
+    return true;
+}
+
+void TransformCache::record(const std::string &mainFile, const std::vector<std::string> &dependencies, const Outputs &outputs)
+{
+    std::string key = normalize(mainFile);
+    Json::Value unit(Json::objectValue);
+    Json::Value deps(Json::objectValue);
+    for(const std::string &path : dependencies)
+    {
+        std::string hash = hashFile(normalize(path));
+        if(hash.empty())
+        {
+            return;     //a dependency we cannot re-check later; do not cache this TU
+        }
+        deps[normalize(path)] = hash;
+    }
+    Json::Value files(Json::objectValue);
+    std::map<std::string, std::string> blobs;
+    for(const auto &output : outputs)
+    {
+        std::string hash = hashContents(output.second);
+        files[output.first] = hash;
+        blobs[hash] = output.second;
+    }
+    unit["dependencies"] = deps;
+    unit["outputs"] = files;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto flags = pendingFlags.find(key);
+    if(flags == pendingFlags.end())
+    {
+        return;
+    }
+    unit["flags"] = flags->second;
+    units[key] = unit;
+    newBlobs.insert(blobs.begin(), blobs.end());
+}
+
+bool TransformCache::save()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if(directory.empty())
+    {
+        return true;
+    }
+    std::error_code EC;
+    std::filesystem::create_directories(directory + "/blobs", EC);
+    if(EC)
+    {
+        llvm::errs() << "Could not create cache directory " << directory << ": " << EC.message() << "\n";
+        return false;
+    }
+
+    bool ok = true;
+    for(const auto &blob : newBlobs)
+    {
+        std::string path = directory + "/blobs/" + blob.first;
+        if(std::filesystem::exists(path))
+        {
+            continue;
+        }
+        std::ofstream out(path, std::ios::binary);
+        out << blob.second;
+        ok = ok && out.good();
+    }
+
+    Json::Value index(Json::objectValue);
+    index["version"] = version;
+    index["units"] = units;
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = " ";
+    std::string tmp = directory + "/index.json.tmp";
+    {
+        std::ofstream out(tmp);
+        out << Json::writeString(builder, index);
+        ok = ok && out.good();
+    }
+    std::filesystem::rename(tmp, directory + "/index.json", EC);
+    if(!ok || EC)
+    {
+        llvm::errs() << "Could not write the cache in " << directory << "\n";
+        return false;
+    }
+    newBlobs.clear();
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef TRANSFORMCACHE_HPP
+#define TRANSFORMCACHE_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <json/json.h>
+
+/*
+ * Persistent cache of rewritten output, one entry per translation unit.
+ *
+ * An entry is valid while the tool version, the TU's compile flags and the
+ * contents of every user file it read (the TU and its non-system headers)
+ * are unchanged; main then hands the stored output files, emitted
+ * specializations included, straight to REWRITE_STORE instead of parsing
+ * the TU again. Layout under the cache directory:
+ *
+ *   index.json         version, and per TU: flags key, dependency hashes,
+ *                      output file -> blob hash
+ *   blobs/<hash>       output file contents, shared between TUs
+ *
+ * Hashes are xxHash64 of file contents, in hex.
+ */
+class TransformCache
+{
+    public:
+        typedef std::vector<std::pair<std::string, std::string>> Outputs;   //output path, contents
+
+        //Read dir/index.json. Entries written by another tool version are dropped.
+        void load(const std::string &dir, const std::string &toolVersion);
+
+        //True if mainFile's entry is valid for flagsKey; outputs gets its files.
+        //On a miss flagsKey is remembered for the record() that follows.
+        bool lookup(const std::string &mainFile, const std::string &flagsKey, Outputs &outputs);
+
+        //Store the result of transforming mainFile. Safe to call from any worker.
+        void record(const std::string &mainFile, const std::vector<std::string> &dependencies, const Outputs &outputs);
+
+        //Write new blobs and the index. Returns false if anything could not be written.
+        bool save();
+
+        bool enabled() const { return !directory.empty(); }
+
+        static std::string hashContents(const std::string &contents);
+        //Hash of path's current contents, or "" if it cannot be read
+        std::string hashFile(const std::string &path);
+
+    private:
+        std::mutex lock;
+        std::string directory;
+        std::string version;
+        Json::Value units;
+        std::map<std::string, std::string> pendingFlags;
+        std::map<std::string, std::string> newBlobs;       //hash -> contents
+        std::map<std::string, std::string> fileHashes;     //path -> hash, for this run
+
+        static std::string normalize(const std::string &path);
+        bool readBlob(const std::string &hash, std::string &contents);
+};
+
+extern TransformCache TRANSFORM_CACHE;
+
+#endif
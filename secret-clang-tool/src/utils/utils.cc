@@ -1,4 +1,5 @@
 #include "utils.h"
+#include <filesystem>
 
 
 namespace utils
@@ -9,6 +10,47 @@ bool fileExists(const std::string &file)
     return std::ifstream(file).good();
 }
 
+bool clearDirectory(const std::string &dir)
+{
+    std::error_code EC;
+    if(!std::filesystem::exists(dir, EC))
+    {
+        return std::filesystem::create_directories(dir, EC) || !EC;
+    }
+    for(const auto &entry : std::filesystem::directory_iterator(dir, EC))
+    {
+        std::filesystem::remove_all(entry.path(), EC);
+        if(EC)
+        {
+            llvm::errs() << "Could not remove " << entry.path().string() << ": " << EC.message() << "\n";
+            return false;
+        }
+    }
+    return !EC;
+}
+
+bool copyDirectoryContents(const std::string &from, const std::string &to)
+{
+    std::error_code EC;
+    std::filesystem::create_directories(to, EC);
+    for(const auto &entry : std::filesystem::directory_iterator(from, EC))
+    {
+        std::filesystem::copy(entry.path(), std::filesystem::path(to) / entry.path().filename(),
+                              std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, EC);
+        if(EC)
+        {
+            llvm::errs() << "Could not copy " << entry.path().string() << " to " << to << ": " << EC.message() << "\n";
+            return false;
+        }
+    }
+    if(EC)
+    {
+        llvm::errs() << "Could not read " << from << ": " << EC.message() << "\n";
+        return false;
+    }
+    return true;
+}
+
 // std::vector<std::string> getCompileArgs(const std::vector<clang::tooling::CompileCommand> &compileCommands)
 // {
 //     std::vector<std::string> compileArgs;
@@ -127,6 +127,11 @@ namespace utils
     };
 
     bool fileExists(const std::string &file);
+
+    //Empty dir (rm -rf dir/*), creating it if it does not exist
+    bool clearDirectory(const std::string &dir);
+    //Copy everything under from into to (cp -r from/* to), overwriting existing files
+    bool copyDirectoryContents(const std::string &from, const std::string &to);
    
 
     class CompoundStmtVisitor : public RecursiveASTVisitor<CompoundStmtVisitor>{
@@ -227,6 +232,7 @@ namespace utils
 
     std::string getMemberInitString(std::map<std::string, std::string>& initMemberlist); 
     std::string getDelegatingInitString(CXXConstructorDecl* Ctor);
+    std::string getFieldInitString(FieldDecl* field);
     std::string getSecretAllocatorCode(std::string secretClassName);
 
 }